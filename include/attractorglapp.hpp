@@ -1,7 +1,10 @@
 #ifndef ATTRACTORGLAPP_HPP
 #define ATTRACTORGLAPP_HPP
 
+#include <atomic>
+#include <future>
 #include <memory>
+#include <sstream>
 
 #include <iglapp.hpp>
 #include <camera.hpp>
@@ -9,6 +12,25 @@
 #include <glm/glm.hpp>
 #include <shader.hpp>
 #include <attractormodel.hpp>
+#include <basinmap.hpp>
+#include <basinmodel.hpp>
+#include <ensemble.hpp>
+#include <ensemblemodel.hpp>
+#include <lyapunovestimator.hpp>
+#include <nearestapproach.hpp>
+#include <trajectorycache.hpp>
+#include <trajectoryloader.hpp>
+#include <pipereader.hpp>
+#include <shmring.hpp>
+#include <syncdistance.hpp>
+#include <odeintegrator.hpp>
+#include <parametercontinuation.hpp>
+#include <poincaresection.hpp>
+#include <pointcloudmodel.hpp>
+#include <recurrencemodel.hpp>
+#include <recurrenceplot.hpp>
+#include <npyfile.hpp>
+#include <trajectoryfile.hpp>
 
 #include <utils.hpp>
 
@@ -44,6 +66,51 @@ public:
     std::string secondAttractorSection();
     void setSecondAttractorSection(std::string dir);
 
+    TrajectoryCache& trajectoryCache();
+
+    /// Nonzero GPU budget draws attractors out-of-core.
+    ResidencyBudget residencyBudget() const;
+    void setResidencyBudget(const ResidencyBudget& budget);
+
+    /// Nonzero number of trajectories integrates ensemble around
+    /// each attractor given as system ("ode:...").
+    Ensemble::Settings& ensembleSettings();
+
+    /// Basins of both attractors under given system ("ode:..."),
+    /// no basins if empty.
+    void setBasinSystem(std::string system);
+    BasinMap::Settings& basinSettings();
+
+    /// Nonzero number of exponents estimates Lyapunov spectra of attractors
+    /// given as systems, file attractors use given system ("ode:...").
+    LyapunovEstimator::Settings& lyapunovSettings();
+    void setLyapunovSystem(std::string system);
+
+    /// Crossings of both attractors with surfaces in drawn coordinates
+    /// are shown as points, no Poincare sections if there are no surfaces.
+    void addPoincareSurface(const PoincareSection::Surface& surface);
+    void setPoincareDirection(PoincareSection::Direction direction);
+
+    /// Second attractor is drawn where it is farther than threshold from first.
+    void setDistanceThreshold(GLfloat threshold);
+    /// Second trajectory is ahead of first by lag points.
+    void setSyncLag(ptrdiff_t lag);
+    /// Lag is estimated once trajectories are loaded.
+    void setSyncLagEstimated(bool estimated);
+
+    /// Attractors are colored by distance of every point to nearest point
+    /// of the other one at any time. Distance threshold keys hide second
+    /// attractor by it instead of by synchronization distance.
+    void setNearestApproach(bool enabled);
+
+    /// Recurrence plot of first or second attractor, or cross-recurrence
+    /// plot of both, drawn in window corner once trajectories are loaded.
+    void setRecurrencePlot(AttractorFilter source);
+    RecurrencePlot::Settings& recurrenceSettings();
+
+    /// Print uniform location lookups per frame whenever they change.
+    void setReportUniformLookups(bool enabled);
+
 protected:
     virtual void configureApp() override;
     virtual void mainLoop() override;
@@ -61,6 +128,28 @@ private:
     constexpr static const GLsizei END_TIME = MAX_TIME - 10;
 
     constexpr static const GLfloat DISTANCE_THRESHOLD = 0.025f;
+    /// Relative change of distance threshold per second of pressed key.
+    constexpr static const GLfloat DISTANCE_THRESHOLD_RATE = 0.5f;
+
+    /// Lags tried and aligned points compared by lag estimation.
+    constexpr static const size_t SYNC_MAX_LAG = 1000;
+    constexpr static const size_t SYNC_LAG_WINDOW = 100000;
+
+    /// Relative change of system parameter per second of pressed key.
+    constexpr static const GLfloat PARAMETER_RATE = 0.05f;
+
+    /// Shift of Poincare surfaces per second of pressed key.
+    constexpr static const GLfloat POINCARE_RATE = 0.25f;
+
+    /// Zoom factor and shift in view sides of recurrence plot per second of pressed key.
+    constexpr static const GLfloat RECURRENCE_ZOOM_RATE = 2.0f;
+    constexpr static const GLfloat RECURRENCE_PAN_RATE = 0.5f;
+
+    /// Seconds between window title updates with Lyapunov estimates.
+    constexpr static const double LYAPUNOV_REPORT_PERIOD = 0.5;
+
+    /// Streamed points appended to each attractor per frame.
+    constexpr static const size_t STREAM_POINTS_PER_FRAME = 1 << 18;
 
     constexpr static const GLfloat COLOR_DELTA = 0.01f;
 
@@ -69,6 +158,8 @@ private:
     static std::unique_ptr<Camera> sCamera;
 
     GLfloat mFpsTimeDelta;
+    Shader::LookupCounters mFrameLookups;
+    bool mReportLookups;
     static std::unique_ptr<FpsManager> sFpsManager;
 
     /// Background.
@@ -84,16 +175,77 @@ private:
     /// First attractor.
     GLfloat mFirstAttractorTime;
     std::unique_ptr<AttractorModel> mFirstAttractor;
+    std::unique_ptr<TrajectoryStream> mFirstAttractorStream;
     std::string mFirstAttractorTrajectory;
     std::string mFirstAttractorSection;
+    std::unique_ptr<EnsembleModel> mFirstEnsemble;
+    std::future<std::vector<glm::vec3>> mFirstEnsembleResult;
 
     /// Second attractor.
     GLfloat mSecondAttractorTime;
     std::unique_ptr<AttractorModel> mSecondAttractor;
+    std::unique_ptr<TrajectoryStream> mSecondAttractorStream;
     std::string mSecondAttractorTrajectory;
     std::string mSecondAttractorSection;
-
-    std::vector<bool> mPositionsToBeDrawnBoth;
+    std::unique_ptr<EnsembleModel> mSecondEnsemble;
+    std::future<std::vector<glm::vec3>> mSecondEnsembleResult;
+
+    TrajectoryCache mTrajectoryCache;
+    ResidencyBudget mResidencyBudget;
+
+    Ensemble::Settings mEnsembleSettings;
+    std::atomic<bool> mEnsemblesCancelled;
+
+    /// Parameter continuation of attractors given as systems.
+    int mSystemParameter;
+    bool mSystemParameterKeyPressed;
+    std::unique_ptr<ParameterContinuation> mFirstContinuation;
+    std::unique_ptr<ParameterContinuation> mSecondContinuation;
+
+    std::string mBasinSystem;
+    BasinMap::Settings mBasinSettings;
+    std::unique_ptr<BasinMap> mBasinMap;
+    std::unique_ptr<BasinModel> mBasinModel;
+
+    std::string mLyapunovSystem;
+    LyapunovEstimator::Settings mLyapunovSettings;
+    std::unique_ptr<LyapunovEstimator> mLyapunovEstimator;
+    std::vector<std::string> mLyapunovNames;
+    bool mLyapunovPending;
+    double mLyapunovReportTime;
+
+    std::vector<PoincareSection::Surface> mPoincareSurfaces;
+    PoincareSection::Direction mPoincareDirection;
+    PoincareSection mFirstPoincare;
+    PoincareSection mSecondPoincare;
+    std::unique_ptr<PointCloudModel> mFirstPoincareCloud;
+    std::unique_ptr<PointCloudModel> mSecondPoincareCloud;
+    std::vector<glm::vec3> mPoincarePoints;
+
+    /// Distances between attractors, those uploaded to second one are kept.
+    SyncDistance mSyncDistance;
+    bool mSyncLagEstimated;
+    GLfloat mDistanceThreshold;
+    bool mDistanceThresholdKeyPressed;
+    size_t mSyncUploadedEnd;
+    /// Distances hold every point, so out-of-core mode goes without them.
+    bool mDistancesEnabled;
+
+    /// Nearest approach fields of attractors, computed once both are loaded.
+    bool mNearestApproach;
+    bool mNearestPending;
+    double mNearestStartTime;
+    std::atomic<bool> mNearestCancelled;
+    std::future<NearestApproach::Field> mFirstNearestResult;
+    std::future<NearestApproach::Field> mSecondNearestResult;
+
+    /// Recurrence plot tiles are computed for current view only.
+    bool mRecurrence;
+    bool mRecurrencePending;
+    AttractorFilter mRecurrenceSource;
+    RecurrencePlot::Settings mRecurrenceSettings;
+    std::unique_ptr<RecurrencePlot> mRecurrencePlot;
+    std::unique_ptr<RecurrenceModel> mRecurrenceModel;
 
     /// Transformations.
     glm::mat4 mProjectionMat;
@@ -102,9 +254,56 @@ private:
 
     std::vector<glm::vec2> readSectionVertices(std::string xFile,
                                                std::string yFile);
-    std::vector<glm::vec3> readAttractorVertices(std::string xFile,
-                                                 std::string yFile,
-                                                 std::string zFile);
+    /// Trajectory is file, standard input ("-"), named pipe
+    /// or shared-memory ring ("shm:name").
+    std::unique_ptr<TrajectoryStream> loadAttractorTrajectory(
+            const std::string& trajectoriesDir, const std::string& trajectory);
+
+    /// Move loaded points to models, returns true if any arrived.
+    bool streamAttractorTrajectories();
+    bool streamAttractorTrajectory(std::unique_ptr<TrajectoryStream>& stream,
+                                   AttractorModel& model);
+
+    /// Ensemble is integrated on pool, invalid future if there is none.
+    std::future<std::vector<glm::vec3>> integrateEnsemble(const std::string& trajectory);
+    void collectEnsembles();
+    std::unique_ptr<EnsembleModel> collectEnsemble(
+            std::future<std::vector<glm::vec3>>& result, const glm::vec4& color);
+    void cancelEnsembles();
+
+    /// Change selected parameter of systems, their attractors are re-integrated.
+    void adjustSystemParameter(bool toIncrement);
+    void selectNextSystemParameter();
+    void adjustSystemParameter(const std::string& trajectory,
+                               std::unique_ptr<ParameterContinuation>& continuation,
+                               std::unique_ptr<TrajectoryStream>& stream,
+                               const AttractorModel& model, GLfloat factor);
+    /// Swap finished re-integrations into models, returns true if any did.
+    bool updateContinuations();
+    bool updateContinuation(std::unique_ptr<ParameterContinuation>& continuation,
+                            AttractorModel& model);
+
+    /// Start basin map once trajectories are loaded, upload its tiles.
+    void updateBasinMap();
+
+    /// Start estimation once trajectories are loaded, show its estimates.
+    void updateLyapunovEstimator();
+    bool lyapunovAttractor(const std::string& trajectory,
+                           const std::unique_ptr<ParameterContinuation>& continuation,
+                           const AttractorModel& model,
+                           LyapunovEstimator::Attractor& attractor) const;
+
+    /// Move Poincare surfaces along their normals or grow spheres.
+    void shiftPoincareSurfaces(bool toIncrement);
+    /// Recompute crossings of changed trajectories or surfaces.
+    void updatePoincareSections();
+    void updatePoincareSection(PoincareSection& section,
+                               const AttractorModel& model,
+                               PointCloudModel& cloud);
+
+    /// Streams, ensembles, basins, estimation, nearest approach and
+    /// recurrence plot stop and their threads are joined.
+    void stopBackgroundWork();
 
     void adjustAttractorTime(bool toIncrement);
     void adjustAttractorColor(const ColorComponent& component, bool toIncrement);
@@ -117,7 +316,33 @@ private:
                                 const glm::vec3& bottomColor
                                ) const;
 
-    void calculatePositionsToBeDrawnBoth();
+    void drawAttractors(const glm::mat4& projViewMat,
+                        GLint from, GLsizei count);
+
+    /// Second attractor gets distances of newly loaded points, it is
+    /// drawn where they are above threshold.
+    void updateSyncDistance();
+    /// Distances are computed anew, e.g. for replaced trajectories.
+    void resetSyncDistance();
+    void adjustDistanceThreshold(bool toIncrement);
+    void reportSyncDistance() const;
+
+    /// Start fields once trajectories are loaded, color attractors by them.
+    void updateNearestApproach();
+    /// Field is computed on pool from current trajectories.
+    std::future<NearestApproach::Field> computeNearestApproach(
+            const AttractorModel& from, const AttractorModel& to);
+    void collectNearestApproach(std::future<NearestApproach::Field>& result,
+                                AttractorModel& model, const std::string& name);
+    void cancelNearestApproach();
+
+    /// Start plot once trajectories are loaded, request tiles of view.
+    void updateRecurrencePlot();
+    void adjustRecurrenceView();
+    /// Plot is drawn over square in lower right corner of window.
+    void drawRecurrencePlot();
+
+    void reportUniformLookups();
 };
 
 #endif // ATTRACTORGLAPP_HPP
@@ -1,6 +1,7 @@
 #ifndef ATTRACTORMODEL_HPP
 #define ATTRACTORMODEL_HPP
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <string>
@@ -8,15 +9,40 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <chunkedtube.hpp>
 #include <glmodel.hpp>
 #include <shader.hpp>
+#include <threadpool.hpp>
+#include <trajectory.hpp>
+#include <tubegeometry.hpp>
 #include <utils.hpp>
 
+/// Disjoint segment ranges, sorted by first segment.
+struct SegmentRanges
+{
+    std::vector<GLint>   firsts;
+    std::vector<GLsizei> counts;
+};
+
+enum TubeMode : int
+{
+    /// Tube vertices are generated on CPU and stored in one mesh.
+    MESH,
+    /// Only frames are uploaded, rings are built in vertex shader.
+    EXTRUDED
+};
+
 class AttractorModel : public GLModel
 {
 public:
-    AttractorModel(std::vector<glm::vec3> vertices,
-                   std::vector<glm::vec2> section);
+    /**
+     * Nonzero GPU budget makes model out-of-core: tube is extruded
+     * per chunk of segments being drawn, see ChunkedTube.
+     */
+    AttractorModel(Trajectory vertices,
+                   std::vector<glm::vec2> section,
+                   TubeMode mode = TubeMode::EXTRUDED,
+                   const ResidencyBudget& budget = ResidencyBudget());
     ~AttractorModel();
 
     virtual void configure() override;
@@ -25,37 +51,156 @@ public:
                       GLint from, GLsizei count);
     virtual void clearVertexData();
 
-    const std::vector<glm::vec3>& getTrajectoryVertices() const;
+    const Trajectory& getTrajectoryVertices() const;
+    GLsizei getNSegments() const;
+
+    /**
+     * Continue trajectory with points, e.g. part of streamed file.
+     * Only frames and geometry of new segments are computed and uploaded.
+     */
+    void appendVertices(const Trajectory& points);
+
+    /**
+     * Replace trajectory, e.g. re-integrated one. Buffers are kept and
+     * only grow if new trajectory does not fit into them.
+     */
+    void setTrajectoryVertices(Trajectory points);
 
     GLfloat getNRadius() const;
     void setRadius(GLfloat radius);
 
+    const std::vector<glm::vec2>& getSectionVertices() const;
+    void setSectionVertices(std::vector<glm::vec2> section);
+
     glm::vec4 getColor() const;
     void setColor(const glm::vec4& color);
 
+    /**
+     * Distances of points [first, first + count), e.g. to other attractor.
+     * Points without distance have zero. Distances live on GPU, where
+     * segments whose bottom point is not farther than threshold are hidden.
+     */
+    void setDistances(const GLfloat* distances, GLsizei first, GLsizei count);
+    void clearDistances();
+
+    GLfloat getDistanceThreshold() const;
+    /// Negative threshold shows all segments.
+    void setDistanceThreshold(GLfloat threshold);
+
+    /**
+     * Points are colored from color at zero distance to far color at
+     * scale and beyond. Non-positive scale draws all in color.
+     */
+    void setDistanceColors(const glm::vec4& farColor, GLfloat scale);
+
+    TubeMode getTubeMode() const;
+    /// Out-of-core model is always extruded.
+    void setTubeMode(TubeMode mode);
+
+    bool isOutOfCore() const;
+
 protected:
 
 private:
     constexpr static const GLfloat   DFLT_RADIUS   = 1.0f;
-
-    std::unique_ptr<Shader> mShader;
-
+    constexpr static const GLuint    RESTART_INDEX = 0xFFFFFFFF;
+
+    /// Points per task of parallel tube generation.
+    constexpr static const GLsizei   MESH_GRAIN    = 16384;
+
+    /// Must match MAX_SECTION_VERTICES in extruded vertex shader.
+    constexpr static const GLsizei   MAX_EXTRUDED_SECTION_VERTICES = 64;
+
+    struct ShaderLocations
+    {
+        GLint trans[4];
+        GLint color;
+        GLint radius;
+        GLint sectionSize;
+        GLint section;
+        GLint threshold;
+        GLint distances;
+        GLint farColor;
+        GLint distanceScale;
+    };
+
+    std::unique_ptr<Shader> mMeshShader;
+    ShaderLocations mMeshLocations;
+
+    std::unique_ptr<Shader> mExtrudedShader;
+    ShaderLocations mExtrudedLocations;
+    bool mSectionUploaded;
+
+    TubeMode mTubeMode;
     GLsizei mNSectionVertices;
     GLfloat mRadius;
     glm::vec4 mColor;
 
-    std::vector<glm::vec3> mTrajectoryVertices;
+    Trajectory mTrajectoryVertices;
     std::vector<glm::vec2> mSectionVertices;
-
-    std::vector<GLuint> mSegmentsVaos;
-    std::vector<GLuint> mSegmentsVbos;
-
-    std::unique_ptr<glm::vec3[]> mVerticesBuffer;
-    std::unique_ptr<glm::vec3[]> mSegmentBuffer;
+    std::vector<TubeFrame> mFrames;
+
+    /// Whole tube: one ring per point, one strip per segment
+    /// separated by restart index.
+    GLuint mVao;
+    GLuint mVbo;
+    GLuint mEbo;
+    GLsizeiptr mVboCapacity;
+    GLsizeiptr mEboCapacity;
+
+    /// Points and frames only: one instance per segment.
+    GLuint mFramesVao;
+    GLuint mPositionsVbo;
+    GLuint mFramesVbo;
+    GLsizeiptr mPositionsCapacity;
+    GLsizeiptr mFramesCapacity;
+
+    GLsizei mNSegments;
+    GLsizei mSegmentNIndices;
+
+    /// Distance per point, read as instanced attribute by extruded tube
+    /// and through buffer texture by mesh.
+    GLuint mDistancesVbo;
+    GLsizeiptr mDistancesCapacity;
+    GLsizei mNDistances;
+    GLuint mDistancesTexture;
+    GLfloat mDistanceThreshold;
+    glm::vec4 mFarColor;
+    GLfloat mDistanceScale;
+
+    /// Ranges clipped to drawn time window.
+    SegmentRanges mVisibleRanges;
+
+    /// Scratch arrays for glMultiDrawElements.
+    std::vector<GLsizei> mMultiDrawCounts;
+    std::vector<const GLvoid*> mMultiDrawOffsets;
+
+    /// Out-of-core tube and its per-draw scratch.
+    std::unique_ptr<ChunkedTube> mChunkedTube;
+    glm::mat4 mDrawMvp;
+    std::vector<GLsizei> mDrawnChunks;
+    SegmentRanges mChunkRanges;
+    std::vector<const ChunkedTube::Chunk*> mResidentChunks;
 
     void setMvpMatrix(const glm::mat4& mvp);
-    void drawSegment(GLint segmentNo);
-    void computeSegment(GLint segmentNo, GLuint& vao, GLuint& vbo);
+    void setDrawState(const glm::mat4& viewProjectionMatrix);
+    void drawVisibleRanges();
+    void drawChunkedRanges();
+    /// Distances are global, so their first segment is given separately.
+    void bindExtrudedSegments(GLuint positionsVbo, GLuint framesVbo, GLint from,
+                              GLint distancesFrom);
+    /// Grow distances to nPoints points, new ones are zero.
+    void reserveDistances(GLsizei nPoints);
+
+    /// Frames of points from given one on, earlier frames are kept.
+    void computeFrames(GLsizei fromPoint = 0);
+    /// Rings of points and indices of segments from given ones on.
+    void computeMesh(GLsizei fromPoint = 0, GLsizei fromSegment = 0);
+    void uploadFrames(GLsizei fromFrame = 0, GLsizei fromPosition = 0);
+
+    /// Grow buffer to at least size bytes keeping its first used bytes.
+    static void reserveBuffer(GLuint& buffer, GLsizeiptr& capacity,
+                              GLsizeiptr used, GLsizeiptr size);
 };
 
 #endif // ATTRACTORMODEL_HPP
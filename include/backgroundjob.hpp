@@ -0,0 +1,177 @@
+#ifndef BACKGROUNDJOB_HPP
+#define BACKGROUNDJOB_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Computation on its own thread handing results to render thread, shared
+ * by loaders and estimators. Job checks isCancelled() between its steps;
+ * exception it throws ends it and is kept as error message. Worker may
+ * sleep in waitUntil() for state changed by update() on render thread.
+ */
+template <typename Result>
+class BackgroundJob
+{
+public:
+    BackgroundJob();
+    ~BackgroundJob();
+
+    BackgroundJob(const BackgroundJob&) = delete;
+    BackgroundJob& operator=(const BackgroundJob&) = delete;
+
+    /// Run job once on new thread.
+    void start(std::function<void()> job);
+
+    /// Worker: hand result to render thread.
+    void push(Result result);
+
+    /// Worker: job should return soon.
+    bool isCancelled() const;
+
+    /**
+     * Worker: sleep until ready() holds, it is called with job mutex held
+     * and may take shared state. Returns false if job was cancelled.
+     */
+    template <typename Ready>
+    bool waitUntil(Ready ready);
+
+    /// Change state read by waitUntil() under job mutex and wake worker.
+    template <typename Change>
+    void update(Change change);
+
+    /// Take next result, false if there is none yet.
+    bool poll(Result& result);
+
+    /// Job returned and all its results are taken.
+    bool isFinished() const;
+
+    /// Message of exception thrown by job, empty if there is none.
+    std::string getError() const;
+
+    /// Stop job at its next step and wait for it.
+    void cancel();
+
+private:
+    std::thread mThread;
+    std::atomic<bool> mCancelled;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mChanged;
+    std::deque<Result> mResults;
+    bool mDone;
+    std::string mError;
+};
+
+template <typename Result>
+BackgroundJob<Result>::BackgroundJob()
+    : mCancelled(false)
+    , mDone(false)
+{
+}
+
+template <typename Result>
+BackgroundJob<Result>::~BackgroundJob()
+{
+    cancel();
+}
+
+template <typename Result>
+void BackgroundJob<Result>::start(std::function<void()> job)
+{
+    mThread = std::thread([this, job]()
+    {
+        std::string error;
+        try
+        {
+            job();
+        }
+        catch (std::exception& exc)
+        {
+            error = exc.what();
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mError = error;
+        mDone = true;
+    });
+}
+
+template <typename Result>
+void BackgroundJob<Result>::push(Result result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mResults.push_back(std::move(result));
+}
+
+template <typename Result>
+bool BackgroundJob<Result>::isCancelled() const
+{
+    return mCancelled.load();
+}
+
+template <typename Result>
+template <typename Ready>
+bool BackgroundJob<Result>::waitUntil(Ready ready)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mChanged.wait(lock, [this, &ready]() { return mCancelled.load() || ready(); });
+    return !mCancelled.load();
+}
+
+template <typename Result>
+template <typename Change>
+void BackgroundJob<Result>::update(Change change)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        change();
+    }
+    mChanged.notify_one();
+}
+
+template <typename Result>
+bool BackgroundJob<Result>::poll(Result& result)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mResults.empty())
+        return false;
+
+    result = std::move(mResults.front());
+    mResults.pop_front();
+    return true;
+}
+
+template <typename Result>
+bool BackgroundJob<Result>::isFinished() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDone && mResults.empty();
+}
+
+template <typename Result>
+std::string BackgroundJob<Result>::getError() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mError;
+}
+
+template <typename Result>
+void BackgroundJob<Result>::cancel()
+{
+    /// Flag is set under mutex, so sleeping worker can't miss it.
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCancelled = true;
+    }
+    mChanged.notify_one();
+    if (mThread.joinable())
+        mThread.join();
+}
+
+#endif // BACKGROUNDJOB_HPP
@@ -0,0 +1,92 @@
+#ifndef BASINMAP_HPP
+#define BASINMAP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <backgroundjob.hpp>
+#include <odeintegrator.hpp>
+#include <pointgrid.hpp>
+#include <trajectory.hpp>
+
+/**
+ * Basins of attraction of two attractors on a square slice of initial
+ * conditions. Every initial condition is integrated past transient and
+ * labelled by the attractor whose points its samples come close to,
+ * found with PointGrid of each attractor. Tiles of the slice are
+ * integrated in parallel on background thread and handed out as they
+ * complete, so the map is drawn progressively.
+ */
+class BasinMap
+{
+public:
+    enum Label : uint8_t
+    {
+        UNKNOWN,
+        FIRST,
+        SECOND,
+        DIVERGED
+    };
+
+    struct Settings
+    {
+        /// Initial conditions per side of slice.
+        int resolution = 256;
+        /// Slice is plane z = center.z, in system coordinates.
+        glm::dvec3 center = glm::dvec3(0.0);
+        double halfSize = 2.0;
+        size_t transient = 5000;
+        size_t samples = 100;
+        /// Sample closer than this to attractor point is near it,
+        /// in drawn coordinates.
+        float distance = 0.05f;
+        int tileSize = 32;
+    };
+
+    struct Tile
+    {
+        int x;
+        int y;
+        int width;
+        int height;
+        /// Row-major labels of tile.
+        std::vector<uint8_t> labels;
+    };
+
+    /// Attractors are drawn points, e.g. loaded trajectories.
+    BasinMap(const OdeIntegrator::Settings& integration, const Settings& settings,
+             Trajectory first, Trajectory second);
+    ~BasinMap();
+
+    BasinMap(const BasinMap&) = delete;
+    BasinMap& operator=(const BasinMap&) = delete;
+
+    /// Take next completed tile, false if there is none yet.
+    bool poll(Tile& tile);
+
+    /// All tiles are computed and taken.
+    bool isFinished() const;
+
+    /// See BackgroundJob, computation stops at next tile.
+    std::string getError() const;
+    void cancel();
+
+    const Settings& getSettings() const;
+
+    /// Initial condition of slice cell (x, y), in system coordinates.
+    glm::dvec3 initialCondition(int x, int y) const;
+
+private:
+    OdeIntegrator::Settings mIntegration;
+    Settings mSettings;
+
+    BackgroundJob<Tile> mJob;
+
+    void compute(Trajectory first, Trajectory second);
+    void computeTile(const PointGrid& first, const PointGrid& second, Tile& tile) const;
+};
+
+#endif // BASINMAP_HPP
@@ -0,0 +1,65 @@
+#ifndef BASINMODEL_HPP
+#define BASINMODEL_HPP
+
+#include <memory>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <basinmap.hpp>
+#include <glmodel.hpp>
+#include <shader.hpp>
+
+/**
+ * Basin map drawn as textured square in the slice plane, so that
+ * it lies among attractors. Texture holds one label per texel and
+ * is filled tile by tile as BasinMap completes them.
+ */
+class BasinModel : public GLModel
+{
+public:
+    /// Slice corner and sides in drawn coordinates.
+    BasinModel(GLsizei resolution, const glm::vec3& origin,
+               const glm::vec3& axisU, const glm::vec3& axisV);
+    ~BasinModel();
+
+    virtual void configure() override;
+    virtual void draw(const glm::mat4& viewProjectionMatrix) override;
+    virtual void clearVertexData();
+
+    void updateTile(const BasinMap::Tile& tile);
+
+    void setColors(const glm::vec4& first, const glm::vec4& second,
+                   const glm::vec4& diverged);
+
+private:
+    struct ShaderLocations
+    {
+        GLint trans[4];
+        GLint origin;
+        GLint axisU;
+        GLint axisV;
+        GLint firstColor;
+        GLint secondColor;
+        GLint divergedColor;
+        GLint labels;
+    };
+
+    std::unique_ptr<Shader> mShader;
+    ShaderLocations mLocations;
+
+    GLsizei mResolution;
+    glm::vec3 mOrigin;
+    glm::vec3 mAxisU;
+    glm::vec3 mAxisV;
+
+    glm::vec4 mFirstColor;
+    glm::vec4 mSecondColor;
+    glm::vec4 mDivergedColor;
+
+    /// Corners are generated from vertex ids, VAO is bound only.
+    GLuint mVao;
+    GLuint mTexture;
+};
+
+#endif // BASINMODEL_HPP
@@ -0,0 +1,105 @@
+#ifndef CHUNKEDTUBE_HPP
+#define CHUNKEDTUBE_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <trajectory.hpp>
+#include <tubegeometry.hpp>
+
+/// Memory limits of out-of-core tube in bytes, zero GPU budget disables it.
+struct ResidencyBudget
+{
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+};
+
+/**
+ * Out-of-core extruded tube. Points stay in their storage (mapped file),
+ * frames and GPU buffers exist only for fixed-size chunks being drawn and
+ * least recently drawn ones are evicted beyond budget. Frames at chunk
+ * starts come from prefix scan of per-chunk transport transforms,
+ * extended up to the furthest chunk drawn so far.
+ */
+class ChunkedTube
+{
+public:
+    /// Segments per chunk.
+    constexpr static const GLsizei CHUNK_SEGMENTS = 1 << 16;
+
+    /// GPU side of chunk, buffers start at its first segment.
+    struct Chunk
+    {
+        GLint   firstSegment = 0;
+        GLsizei nSegments    = 0;
+        GLuint  positionsVbo = 0;
+        GLuint  framesVbo    = 0;
+    };
+
+    ChunkedTube(const Trajectory& points, const ResidencyBudget& budget);
+    ~ChunkedTube();
+
+    ChunkedTube(const ChunkedTube&) = delete;
+    ChunkedTube& operator=(const ChunkedTube&) = delete;
+
+    /// Points were appended after given former last point.
+    void invalidateFrom(GLsizei point);
+
+    static GLsizei chunkOf(GLint segment);
+
+    /// Chunk bounds inflated by radius intersect view frustum.
+    bool isVisible(GLsizei chunk, const glm::mat4& mvp, GLfloat radius);
+
+    /**
+     * Make chunks resident, missing frames are computed in parallel.
+     * Returned pointers are valid until next call.
+     */
+    void acquire(const std::vector<GLsizei>& chunks,
+                 std::vector<const Chunk*>& resident);
+
+    /// Evict least recently used chunks not acquired since last call.
+    void evict();
+
+    /// Delete all GPU buffers.
+    void clear();
+
+private:
+    struct Resident
+    {
+        std::vector<TubeFrame> frames;
+        Chunk gpu;
+        uint64_t lastUse = 0;
+    };
+
+    const Trajectory& mPoints;
+    ResidencyBudget mBudget;
+
+    /// Prefix scan, entries of chunks scanned so far.
+    std::vector<glm::mat3> mTransforms;
+    std::vector<glm::vec3> mStarts;
+    /// Last valid tangent up to chunk end, carried over repeated points.
+    std::vector<glm::vec3> mEndTangents;
+    std::vector<glm::vec3> mBoundsMin;
+    std::vector<glm::vec3> mBoundsMax;
+
+    std::unordered_map<GLsizei, Resident> mResident;
+    uint64_t mClock;
+    size_t mCpuBytes;
+    size_t mGpuBytes;
+
+    GLsizei getNSegments() const;
+    GLint chunkEnd(GLsizei chunk) const;
+
+    void scanTo(GLsizei chunk);
+    /// Tangent carried into first point of scanned chunk.
+    glm::vec3 carriedTangent(GLsizei chunk) const;
+    void computeFrames(GLsizei chunk, std::vector<TubeFrame>& frames) const;
+    void upload(Resident& resident, GLsizei chunk);
+    void releaseGpu(Resident& resident);
+};
+
+#endif // CHUNKEDTUBE_HPP
@@ -0,0 +1,47 @@
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <odeintegrator.hpp>
+
+/**
+ * Many trajectories of one system started from initial points scattered
+ * around its initial condition. Trajectories are stepped in lockstep with
+ * fixed RK4 steps, vector lanes of OdeSystem::rk4Lanes holding
+ * different trajectories, and blocks of them run on all pool threads.
+ */
+namespace Ensemble
+{
+
+struct Settings
+{
+    /// No ensemble is integrated for zero trajectories.
+    size_t nTrajectories = 0;
+    size_t nPoints = 2000;
+    /// Radius of ball of initial points, in system coordinates.
+    double radius = 0.01;
+    unsigned int seed = 1;
+};
+
+/// Initial points uniformly distributed in ball around center.
+std::vector<glm::dvec3> initialPoints(const glm::dvec3& center, double radius,
+                                      size_t count, unsigned int seed);
+
+/**
+ * Points of all trajectories, nPoints of each one after another, after
+ * skipping transient points of integration settings. Stops early leaving
+ * rest of points zero when cancelled is set.
+ * Throws runtime_error if any trajectory diverges.
+ */
+std::vector<glm::vec3> integrate(const OdeIntegrator::Settings& integration,
+                                 const Settings& settings,
+                                 const std::atomic<bool>& cancelled);
+
+}
+
+#endif // ENSEMBLE_HPP
@@ -0,0 +1,59 @@
+#ifndef ENSEMBLEMODEL_HPP
+#define ENSEMBLEMODEL_HPP
+
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <glmodel.hpp>
+#include <shader.hpp>
+
+/**
+ * Thousands of trajectories drawn as thin lines, e.g. Ensemble result.
+ * All of them live in one buffer and are drawn by one multi-draw call
+ * of line strips clipped to the drawn time window.
+ */
+class EnsembleModel : public GLModel
+{
+public:
+    /// Points hold nPoints points of every trajectory one after another.
+    EnsembleModel(std::vector<glm::vec3> points,
+                  GLsizei nTrajectories, GLsizei nPoints);
+    ~EnsembleModel();
+
+    virtual void configure() override;
+    virtual void draw(const glm::mat4& viewProjectionMatrix) override;
+    /// Segments [from, from + count) of every trajectory.
+    virtual void draw(const glm::mat4& viewProjectionMatrix,
+                      GLint from, GLsizei count);
+    virtual void clearVertexData();
+
+    GLsizei getNTrajectories() const;
+    GLsizei getNPoints() const;
+
+    glm::vec4 getColor() const;
+    void setColor(const glm::vec4& color);
+
+private:
+    std::unique_ptr<Shader> mShader;
+    GLint mTransLocations[4];
+    GLint mColorLocation;
+
+    glm::vec4 mColor;
+
+    /// Released once uploaded.
+    std::vector<glm::vec3> mPoints;
+    GLsizei mNTrajectories;
+    GLsizei mNPoints;
+
+    GLuint mVao;
+    GLuint mVbo;
+
+    /// Scratch arrays for glMultiDrawArrays.
+    std::vector<GLint>   mMultiDrawFirsts;
+    std::vector<GLsizei> mMultiDrawCounts;
+};
+
+#endif // ENSEMBLEMODEL_HPP
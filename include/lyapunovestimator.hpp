@@ -0,0 +1,85 @@
+#ifndef LYAPUNOVESTIMATOR_HPP
+#define LYAPUNOVESTIMATOR_HPP
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <backgroundjob.hpp>
+#include <odesystem.hpp>
+
+/**
+ * Lyapunov exponents of attractors of built-in systems. Three tangent
+ * vectors are integrated along trajectory with RK4 on the variational
+ * equation and orthonormalized by Gram-Schmidt every few steps; logs of
+ * their stretch factors averaged over time converge to the spectrum.
+ * Runs until cancelled on background thread, attractors are advanced
+ * in parallel on the thread pool and estimates are updated after every
+ * slice of steps.
+ */
+class LyapunovEstimator
+{
+public:
+    struct Settings
+    {
+        /// Exponents reported, 1 for the largest only, at most 3.
+        int nExponents = 1;
+        /// Steps before averaging starts, so that state is on attractor.
+        size_t transient = 10000;
+        /// Steps between renormalizations.
+        size_t renormalization = 10;
+        /// Steps of each attractor between estimate updates.
+        size_t sliceSteps = 20000;
+    };
+
+    struct Attractor
+    {
+        OdeSystem system;
+        /// In system coordinates.
+        glm::dvec3 start;
+    };
+
+    struct Estimate
+    {
+        /// Descending, per unit of system time.
+        std::vector<double> exponents;
+        /// Averaging time so far.
+        double time = 0.0;
+    };
+
+    LyapunovEstimator(std::vector<Attractor> attractors, const Settings& settings);
+    ~LyapunovEstimator();
+
+    LyapunovEstimator(const LyapunovEstimator&) = delete;
+    LyapunovEstimator& operator=(const LyapunovEstimator&) = delete;
+
+    /// Running estimates in order of attractors, latest of those taken.
+    std::vector<Estimate> getEstimates();
+
+    /// See BackgroundJob, estimation stops at next slice.
+    std::string getError() const;
+    void cancel();
+
+private:
+    struct State
+    {
+        glm::dvec3 x;
+        glm::dvec3 v[3];
+        double logSums[3] = { 0.0, 0.0, 0.0 };
+        size_t steps = 0;
+    };
+
+    std::vector<Attractor> mAttractors;
+    Settings mSettings;
+    /// Render thread only.
+    std::vector<Estimate> mEstimates;
+
+    /// Estimates of all attractors after every slice.
+    BackgroundJob<std::vector<Estimate>> mJob;
+
+    void run();
+    void advance(const Attractor& attractor, State& state) const;
+};
+
+#endif // LYAPUNOVESTIMATOR_HPP
@@ -0,0 +1,29 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+/// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& fileName);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const;
+    size_t size() const;
+
+    const std::string& fileName() const;
+
+private:
+    std::string mFileName;
+    void* mData;
+    size_t mSize;
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,46 @@
+#ifndef NEARESTAPPROACH_HPP
+#define NEARESTAPPROACH_HPP
+
+#include <atomic>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <pointgrid.hpp>
+#include <trajectory.hpp>
+
+/**
+ * Nearest approach of one trajectory to another at any time: for every
+ * point of first, distance to nearest point of second. Second is indexed
+ * by PointGrid built on pool, blocks of first are queried in parallel and
+ * every query starts from the answer for previous point, which is near
+ * along smooth trajectory.
+ */
+namespace NearestApproach
+{
+
+struct Field
+{
+    /// Per point of first trajectory.
+    std::vector<float> distances;
+    /// Distance most points are within, e.g. to map distances to colors.
+    float scale = 0.0f;
+};
+
+/// Part of distances within Field::scale.
+const float SCALE_QUANTILE = 0.95f;
+
+/// Cell size of grid with few points per cell for trajectory of n points.
+float cellSize(const Trajectory& points);
+
+/**
+ * Distances of points of from to those of grid, empty field if either
+ * is empty. Stops early leaving rest of distances zero when cancelled
+ * is set.
+ */
+Field compute(const Trajectory& from, const PointGrid& to,
+              const std::atomic<bool>& cancelled);
+
+}
+
+#endif // NEARESTAPPROACH_HPP
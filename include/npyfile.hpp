@@ -0,0 +1,32 @@
+#ifndef NPYFILE_HPP
+#define NPYFILE_HPP
+
+#include <stdexcept>
+#include <string>
+
+#include <trajectory.hpp>
+
+/**
+ * NumPy arrays of trajectory points: shape (N, 3) in C or Fortran order,
+ * or (3, N) in C order, float32 or float64, little-endian.
+ * C-ordered float32 (N, 3) data is mapped and used in place.
+ */
+namespace NpyFile
+{
+
+const char NPY_EXTENSION[] = ".npy";
+const char NPZ_EXTENSION[] = ".npz";
+
+/**
+ * Read .npy file or array of .npz archive: arrayName without .npy suffix,
+ * first array of shape (N, 3) if empty. Only stored (np.savez) archives can be read,
+ * compressed ones (np.savez_compressed) are rejected.
+ */
+Trajectory read(const std::string& fileName,
+                const std::string& arrayName = std::string());
+
+bool hasExtension(const std::string& fileName);
+
+}
+
+#endif // NPYFILE_HPP
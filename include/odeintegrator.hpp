@@ -0,0 +1,60 @@
+#ifndef ODEINTEGRATOR_HPP
+#define ODEINTEGRATOR_HPP
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <odesystem.hpp>
+
+/**
+ * Integrates built-in systems in process, so trajectories need no files.
+ * Trajectory argument names system and overrides its settings, e.g.
+ * "ode:lorenz:rho=99.96,x0=0.1,n=500000,method=rk4". Keys are system
+ * parameters, initial point x0, y0, z0, point spacing dt, number of points n,
+ * number of skipped transient points skip, method rk4 or dopri5, tolerance tol
+ * of dopri5 and view scale.
+ */
+namespace OdeIntegrator
+{
+
+const char PREFIX[] = "ode:";
+
+enum class Method
+{
+    RK4,     ///< Classic Runge-Kutta, one step of dt per point.
+    DOPRI5   ///< Dormand-Prince 5(4) with adaptive steps, dense output at dt.
+};
+
+struct Settings
+{
+    OdeSystem system;
+    Method method = Method::DOPRI5;
+    /// Relative and absolute local error tolerance of adaptive steps.
+    double tolerance = 1e-9;
+    size_t nPoints = 1000000;
+    size_t skip = 0;
+};
+
+bool hasPrefix(const std::string& trajectory);
+
+/// Settings of trajectory argument, throws runtime_error for bad one.
+Settings parse(const std::string& trajectory);
+
+/// One classic Runge-Kutta step of size h.
+glm::dvec3 rk4Step(const OdeSystem& system, const glm::dvec3& x, double h);
+
+/**
+ * Integrate and pass scaled points to sink in batches as they are computed.
+ * Sink returns false to stop. Returns last point in system coordinates,
+ * e.g. to continue from it. Throws runtime_error if trajectory diverges.
+ */
+glm::dvec3 integrate(const Settings& settings,
+               const std::function<bool(std::vector<glm::vec3>)>& sink);
+
+}
+
+#endif // ODEINTEGRATOR_HPP
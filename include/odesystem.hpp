@@ -0,0 +1,65 @@
+#ifndef ODESYSTEM_HPP
+#define ODESYSTEM_HPP
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Autonomous system x' = f(x, p) in three dimensions with parameters p.
+ * Built-in systems carry classic parameters and initial conditions
+ * that can be overridden, and view scale fitting them into the scene.
+ */
+struct OdeSystem
+{
+    using Rhs = glm::dvec3 (*)(const glm::dvec3& x, const double* parameters);
+
+    /**
+     * Advance count trajectories given by SoA coordinates x, y, z, points
+     * 0 to nPoints-1 (point 0 is the start) of trajectory i are written
+     * multiplied by scale to out[i*stride + k]. Points below skip are
+     * not written. Classic Runge-Kutta steps of dt, vectorized over
+     * trajectories; x, y, z are left at the last point.
+     */
+    using Rk4Lanes = void (*)(double* x, double* y, double* z, size_t count,
+                              const double* parameters, double dt,
+                              size_t skip, size_t nPoints, double scale,
+                              glm::vec3* out, size_t stride);
+
+    /**
+     * Right-hand side dx = f(x) with derivatives dv[k] = J(x) v[k] along
+     * three tangent vectors, exact as they are carried through f.
+     */
+    using TangentRhs = void (*)(const double* parameters,
+                                const glm::dvec3& x, const glm::dvec3* v,
+                                glm::dvec3& dx, glm::dvec3* dv);
+
+    std::string name;
+    std::vector<std::string> parameterNames;
+    std::vector<double> parameters;
+    glm::dvec3 initial;
+    /// Time between trajectory points.
+    double dt;
+    /// Points are multiplied by scale before drawing.
+    double scale;
+    Rhs rhs;
+    Rk4Lanes rk4Lanes;
+    TangentRhs tangentRhs;
+
+    glm::dvec3 operator()(const glm::dvec3& x) const
+    {
+        return rhs(x, parameters.data());
+    }
+
+    /// Index of parameter or -1.
+    int parameterIndex(const std::string& parameterName) const;
+
+    /// Built-in system by name, throws runtime_error for unknown one.
+    static const OdeSystem& find(const std::string& name);
+
+    /// Coullet, Lorenz, Rossler, Chen and Thomas systems.
+    static const std::vector<OdeSystem>& builtIn();
+};
+
+#endif // ODESYSTEM_HPP
@@ -0,0 +1,72 @@
+#ifndef PARAMETERCONTINUATION_HPP
+#define PARAMETERCONTINUATION_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <odeintegrator.hpp>
+#include <trajectory.hpp>
+
+/**
+ * Follows attractor of built-in system while one of its parameters
+ * changes. Every change re-integrates on background thread starting
+ * from last state of previous run and drops transient, so attractor
+ * is reached quickly and stays on the same branch. Runs go on one
+ * long-lived thread; change drops run in flight without waiting for it,
+ * so parameter can change every frame.
+ */
+class ParameterContinuation
+{
+public:
+    /// Points dropped after warm start when settings skip fewer.
+    static const size_t DFLT_TRANSIENT = 2000;
+
+    /// Settings of shown trajectory and state to start from, e.g. its last point.
+    ParameterContinuation(const OdeIntegrator::Settings& settings,
+                          const glm::dvec3& start);
+    ~ParameterContinuation();
+
+    ParameterContinuation(const ParameterContinuation&) = delete;
+    ParameterContinuation& operator=(const ParameterContinuation&) = delete;
+
+    const OdeIntegrator::Settings& getSettings() const;
+
+    /// Restart integration with new parameter value, does not block.
+    void setParameter(int idx, double value);
+
+    /// Whole trajectory of last finished run, false if no new run finished.
+    bool poll(Trajectory& points);
+
+    /// Message of failed run, e.g. divergence, reported once.
+    bool takeError(std::string& error);
+
+private:
+    OdeIntegrator::Settings mSettings;
+    /// Last state of last finished run.
+    glm::dvec3 mStart;
+
+    std::thread mThread;
+    /// Bumped by every change, runs of older ones stop and are dropped.
+    std::atomic<uint64_t> mGeneration;
+
+    std::mutex mMutex;
+    std::condition_variable mChanged;
+    bool mStop;
+    /// Generation of run started last.
+    uint64_t mStarted;
+    bool mFinished;
+    std::vector<glm::vec3> mResult;
+    std::string mError;
+
+    /// Run latest change until destruction.
+    void run();
+};
+
+#endif // PARAMETERCONTINUATION_HPP
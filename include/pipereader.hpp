@@ -0,0 +1,87 @@
+#ifndef PIPEREADER_HPP
+#define PIPEREADER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <spscring.hpp>
+#include <trajectorystream.hpp>
+
+/**
+ * Live trajectory from standard input or named pipe, e.g. output of
+ * running integrator. Each line holds x y z separated by blanks or commas.
+ * Reader thread parses lines into lock-free ring drained by render thread;
+ * full ring blocks reader, so producer is slowed down but no point is lost.
+ */
+class PipeReader : public TrajectoryStream
+{
+public:
+    /// Name of standard input on command line.
+    constexpr static const char* STDIN_NAME = "-";
+
+    explicit PipeReader(const std::string& fileName);
+    ~PipeReader();
+
+    PipeReader(const PipeReader&) = delete;
+    PipeReader& operator=(const PipeReader&) = delete;
+
+    virtual bool poll(Trajectory& points, size_t maxPoints) override;
+
+    /// Writer closed pipe and all points are taken.
+    virtual bool isFinished() const override;
+
+    virtual std::string getError() const override;
+
+    virtual void cancel() override;
+
+private:
+    /// Points buffered between reader and render thread.
+    constexpr static const size_t RING_CAPACITY = 1 << 21;
+    /// Bytes requested from pipe at once.
+    constexpr static const size_t READ_SIZE = 1 << 16;
+    /// Period of checking for cancel while pipe is silent.
+    constexpr static const int POLL_TIMEOUT_MS = 100;
+
+    std::string mFileName;
+    int mFd;
+
+    SpscRing<glm::vec3> mRing;
+    std::thread mThread;
+    std::atomic<bool> mCancelled;
+    std::atomic<bool> mDone;
+
+    /// Reader sleeps on full ring until render thread drains it.
+    std::mutex mSpaceMutex;
+    std::condition_variable mDrained;
+
+    mutable std::mutex mErrorMutex;
+    std::string mError;
+
+    void readLoop();
+
+    /// Parse complete lines, returns pointer past the last one.
+    const char* parseLines(const char* begin, const char* end,
+                           std::vector<glm::vec3>& points);
+
+    /// Append point of single line, blank lines are skipped.
+    void parseLine(const char* begin, const char* end,
+                   std::vector<glm::vec3>& points);
+
+    /// Push points into ring, waiting while it is full.
+    bool pushPoints(const std::vector<glm::vec3>& points);
+
+    /// Reader thread only.
+    size_t mLine;
+    size_t mNMalformed;
+
+    /// Render thread only.
+    std::vector<glm::vec3> mScratch;
+};
+
+#endif // PIPEREADER_HPP
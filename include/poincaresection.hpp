@@ -0,0 +1,96 @@
+#ifndef POINCARESECTION_HPP
+#define POINCARESECTION_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <trajectory.hpp>
+
+/**
+ * Poincare map of trajectory: points where it crosses given surfaces,
+ * linearly interpolated between samples. Trajectory is split into chunks
+ * of points with bounding boxes, chunks whose box lies on one side of
+ * surface are skipped and the others are scanned in parallel. Boxes are
+ * kept while surfaces move, appended points only update last chunks.
+ */
+class PoincareSection
+{
+public:
+    struct Surface
+    {
+        enum Kind : int
+        {
+            /// Points x with dot(normal, x) = offset.
+            PLANE,
+            /// Points x with distance(center, x) = offset.
+            SPHERE
+        };
+
+        Kind kind;
+        glm::vec3 normal;
+        glm::vec3 center;
+        float offset;
+
+        static Surface plane(const glm::vec3& normal, float offset);
+        static Surface sphere(const glm::vec3& center, float radius);
+
+        /// Negative on one side, positive on the other.
+        float value(const glm::vec3& point) const;
+        /// Bounds of value over box.
+        void range(const glm::vec3& min, const glm::vec3& max,
+                   float& low, float& high) const;
+    };
+
+    enum Direction : int
+    {
+        /// From negative to positive side, e.g. along plane normal.
+        UPWARD,
+        DOWNWARD,
+        BOTH
+    };
+
+    PoincareSection();
+
+    /// Crossings are computed anew by next update.
+    void setSurfaces(std::vector<Surface> surfaces, Direction direction = UPWARD);
+    const std::vector<Surface>& getSurfaces() const;
+    Direction getDirection() const;
+
+    /// Trajectory was replaced, not only continued.
+    void invalidate();
+
+    /**
+     * Points must continue those of previous update unless invalidate()
+     * was called in between. Returns true if crossings changed.
+     */
+    bool update(const Trajectory& points);
+
+    /// Crossings of surface in order of time.
+    const std::vector<glm::vec3>& getCrossings(size_t surface) const;
+
+private:
+    /// Points per chunk, chunk holds its segments and point after them.
+    static const size_t CHUNK_POINTS = 256;
+    /// Chunks per task of parallel scan.
+    static const size_t CHUNK_GRAIN = 64;
+
+    std::vector<Surface> mSurfaces;
+    Direction mDirection;
+
+    size_t mNPoints;
+    std::vector<glm::vec3> mChunkMin;
+    std::vector<glm::vec3> mChunkMax;
+    /// Chunks from these on are to be computed.
+    size_t mFirstDirtyBounds;
+    size_t mFirstDirtyCrossings;
+
+    /// Crossings of every surface in every chunk, and joined per surface.
+    std::vector<std::vector<std::vector<glm::vec3>>> mChunkCrossings;
+    std::vector<std::vector<glm::vec3>> mCrossings;
+
+    void computeBounds(const Trajectory& points, size_t chunk);
+    void computeCrossings(const Trajectory& points, size_t surface, size_t chunk);
+};
+
+#endif // POINCARESECTION_HPP
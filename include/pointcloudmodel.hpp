@@ -0,0 +1,52 @@
+#ifndef POINTCLOUDMODEL_HPP
+#define POINTCLOUDMODEL_HPP
+
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <glmodel.hpp>
+#include <shader.hpp>
+
+/**
+ * Points drawn as square dots, e.g. crossings of Poincare section.
+ * Points are replaced as a whole, buffer only grows if they do not fit.
+ */
+class PointCloudModel : public GLModel
+{
+public:
+    PointCloudModel();
+    ~PointCloudModel();
+
+    virtual void configure() override;
+    virtual void draw(const glm::mat4& viewProjectionMatrix) override;
+    virtual void clearVertexData();
+
+    void setPoints(const std::vector<glm::vec3>& points);
+    GLsizei getNPoints() const;
+
+    glm::vec4 getColor() const;
+    void setColor(const glm::vec4& color);
+
+    GLfloat getPointSize() const;
+    void setPointSize(GLfloat size);
+
+private:
+    constexpr static const GLfloat DFLT_POINT_SIZE = 3.0f;
+
+    std::unique_ptr<Shader> mShader;
+    GLint mTransLocations[4];
+    GLint mColorLocation;
+
+    glm::vec4 mColor;
+    GLfloat mPointSize;
+
+    GLuint mVao;
+    GLuint mVbo;
+    GLsizeiptr mVboCapacity;
+    GLsizei mNPoints;
+};
+
+#endif // POINTCLOUDMODEL_HPP
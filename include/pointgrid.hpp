@@ -0,0 +1,62 @@
+#ifndef POINTGRID_HPP
+#define POINTGRID_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <trajectory.hpp>
+
+/**
+ * Spatial index of trajectory points: uniform grid of cubic cells,
+ * only non-empty cells are stored in hash map. Queries within a few
+ * cell sizes visit neighboring cells only, independent of point count.
+ */
+class PointGrid
+{
+public:
+    static const size_t NONE = SIZE_MAX;
+
+    PointGrid();
+    /// Cell size is enlarged if bounds need more than 2^21 cells per axis.
+    PointGrid(Trajectory points, float cellSize);
+
+    /// Index of nearest point within maxDistance, NONE if there is none.
+    size_t nearest(const glm::vec3& point, float maxDistance) const;
+
+    /**
+     * Index of nearest point at any distance, NONE only for empty grid or
+     * NaN point. Shells of cells around point are searched until no
+     * unvisited cell can hold a nearer point. Hint is index of a point
+     * likely to be near, e.g. result for previous point of a trajectory,
+     * its distance ends search early.
+     */
+    size_t nearestAny(const glm::vec3& point, size_t hint = NONE) const;
+
+    const Trajectory& getPoints() const;
+    float getCellSize() const;
+    bool empty() const;
+
+private:
+    static const int KEY_BITS = 21;
+
+    Trajectory mPoints;
+    float mCellSize;
+    glm::vec3 mMin;
+    glm::vec3 mMax;
+
+    /// Point indices sorted by cell and range of every cell in them,
+    /// points in same order so that cell is scanned contiguously.
+    std::vector<size_t> mOrder;
+    std::vector<glm::vec3> mSorted;
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> mCells;
+
+    glm::ivec3 cellOf(const glm::vec3& point) const;
+    static uint64_t keyOf(const glm::ivec3& cell);
+};
+
+#endif // POINTGRID_HPP
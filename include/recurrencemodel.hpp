@@ -0,0 +1,107 @@
+#ifndef RECURRENCEMODEL_HPP
+#define RECURRENCEMODEL_HPP
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <glmodel.hpp>
+#include <recurrenceplot.hpp>
+#include <shader.hpp>
+
+/**
+ * Zoomable view of RecurrencePlot drawn over the whole viewport. Tiles
+ * live in layers of one texture array used as cache, least recently
+ * drawn tile makes room for new one. View picks pyramid level with about
+ * one texel per pixel; tile of that level which is not computed yet is
+ * drawn from its nearest coarser ancestor in cache.
+ */
+class RecurrenceModel : public GLModel
+{
+public:
+    /// Plot of width x height points, see RecurrencePlot.
+    RecurrenceModel(size_t width, size_t height, int topLevel);
+    ~RecurrenceModel();
+
+    virtual void configure() override;
+    /// Matrix maps view square [-1, 1]^2, e.g. identity for whole viewport.
+    virtual void draw(const glm::mat4& viewProjectionMatrix) override;
+    virtual void clearVertexData();
+
+    void updateTile(const RecurrencePlot::Tile& tile);
+
+    /// Side of viewport in pixels, which picks drawn level.
+    void setViewportSize(GLsizei pixels);
+
+    /**
+     * Tiles missing in cache that view needs, most wanted first:
+     * whole plot, then tiles of drawn level from view center out.
+     */
+    std::vector<RecurrencePlot::TileKey> missingTiles() const;
+
+    /// Zoom in for factor above one, view stays within plot.
+    void zoom(GLfloat factor);
+    /// Move view by delta in parts of its side.
+    void pan(const glm::vec2& delta);
+
+    void setColors(const glm::vec4& recurrent, const glm::vec4& background);
+
+private:
+    /// Tiles kept in texture array.
+    constexpr static const GLsizei CACHE_TILES = 256;
+    /// View is not zoomed in beyond this many pixels per point.
+    constexpr static const GLfloat MAX_POINT_PIXELS = 16.0f;
+
+    struct ShaderLocations
+    {
+        GLint trans[4];
+        GLint rect;
+        GLint texRect;
+        GLint layer;
+        GLint recurrentColor;
+        GLint backgroundColor;
+        GLint rates;
+    };
+
+    struct Slot
+    {
+        GLint layer;
+        /// Frame in which tile was drawn last.
+        size_t used;
+    };
+
+    std::unique_ptr<Shader> mShader;
+    ShaderLocations mLocations;
+
+    size_t mWidth;
+    size_t mHeight;
+    int mTopLevel;
+
+    /// View center and half of side in parts of plot side.
+    glm::vec2 mCenter;
+    GLfloat mHalfSize;
+    GLsizei mPixels;
+
+    glm::vec4 mRecurrentColor;
+    glm::vec4 mBackgroundColor;
+
+    std::map<RecurrencePlot::TileKey, Slot> mSlots;
+    std::vector<GLint> mFreeLayers;
+    size_t mFrame;
+
+    /// Corners are generated from vertex ids, VAO is bound only.
+    GLuint mVao;
+    GLuint mTexture;
+
+    /// Level with about one texel per pixel of view.
+    int viewLevel() const;
+    /// Tiles of level in view, inclusive.
+    void visibleTiles(int level, glm::ivec2& first, glm::ivec2& last) const;
+    /// Plot rectangle of tile in parts of plot side.
+    glm::vec4 tileRect(const RecurrencePlot::TileKey& key) const;
+};
+
+#endif // RECURRENCEMODEL_HPP
@@ -0,0 +1,101 @@
+#ifndef RECURRENCEPLOT_HPP
+#define RECURRENCEPLOT_HPP
+
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <backgroundjob.hpp>
+#include <trajectory.hpp>
+
+/**
+ * Recurrence plot of two trajectories, e.g. of one with itself: texel
+ * (i, j) is set where point i of first and point j of second are closer
+ * than threshold. Plot is a pyramid of square tiles, texel of level L
+ * covering 2^L x 2^L point pairs and holding their recurrence rate
+ * estimated from a few samples per axis. Only requested tiles are
+ * computed, so that huge plots cost what is shown. Tiles are small
+ * enough for their sampled points to stay in cache, distances go four
+ * at once with SIMD and tiles of each request run on all pool threads.
+ */
+class RecurrencePlot
+{
+public:
+    /// Texels per side of tile.
+    static const int TILE_SIZE = 256;
+
+    struct Settings
+    {
+        /// Points closer than this recur, in drawn coordinates.
+        float threshold = 0.05f;
+        /// Samples per axis of coarse texel, at most 2^L.
+        int samples = 4;
+    };
+
+    struct TileKey
+    {
+        int level;
+        /// In tiles of level, x along first trajectory, y along second.
+        int x;
+        int y;
+
+        bool operator==(const TileKey& other) const;
+        bool operator<(const TileKey& other) const;
+    };
+
+    struct Tile
+    {
+        TileKey key;
+        /// Row-major recurrence rates scaled to 255, rows along y.
+        std::vector<uint8_t> rates;
+    };
+
+    RecurrencePlot(Trajectory first, Trajectory second, const Settings& settings);
+    ~RecurrencePlot();
+
+    RecurrencePlot(const RecurrencePlot&) = delete;
+    RecurrencePlot& operator=(const RecurrencePlot&) = delete;
+
+    /// Points along x and y.
+    size_t getWidth() const;
+    size_t getHeight() const;
+    /// Level whose only tile covers whole plot.
+    int getTopLevel() const;
+    const Settings& getSettings() const;
+
+    /**
+     * Tiles to compute next, most wanted first. Replaces previous
+     * requests not started yet, tiles being computed are skipped.
+     */
+    void request(const std::vector<TileKey>& keys);
+
+    /// Take next computed tile, false if there is none yet.
+    bool poll(Tile& tile);
+
+    /// See BackgroundJob, computation stops after tiles being computed.
+    std::string getError() const;
+    void cancel();
+
+    /// Compute tile of key on calling thread.
+    void computeTile(Tile& tile) const;
+
+private:
+    Trajectory mFirst;
+    Trajectory mSecond;
+    Settings mSettings;
+    int mTopLevel;
+
+    /// Guarded by job mutex.
+    std::deque<TileKey> mRequests;
+    std::set<TileKey> mComputing;
+
+    BackgroundJob<Tile> mJob;
+
+    void run();
+};
+
+#endif // RECURRENCEPLOT_HPP
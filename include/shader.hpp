@@ -5,6 +5,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -18,26 +19,51 @@ public:
 
     unsigned int getID();
 
+    /// Location of active uniform or -1, resolved without driver calls.
+    int getUniformLocation(const std::string& name) const;
+
+    /// Number of uniform location lookups since last reset.
+    struct LookupCounters
+    {
+        unsigned long driver;
+        unsigned long cached;
+    };
+    static LookupCounters getLookupCounters();
+    static void resetLookupCounters();
+
     void setBool(const std::string& name, bool value) const;
+    void setBool(int location, bool value) const;
 
     void setInt(const std::string& name, int value) const;
+    void setInt(int location, int value) const;
 
     void setFloat(const std::string& name, float value) const;
+    void setFloat(int location, float value) const;
 
     void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec2(const std::string& name, float x, float y) const;
+    void setVec2(int location, const glm::vec2& value) const;
+    void setVec2(int location, float x, float y) const;
+    void setVec2Array(int location, const glm::vec2* values, int count) const;
 
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setVec3(const std::string& name, float x, float y, float z) const;
+    void setVec3(int location, const glm::vec3& value) const;
+    void setVec3(int location, float x, float y, float z) const;
 
     void setVec4(const std::string& name, const glm::vec4& value) const;
     void setVec4(const std::string& name, float x, float y, float z, float w) const;
+    void setVec4(int location, const glm::vec4& value) const;
+    void setVec4(int location, float x, float y, float z, float w) const;
 
     void setMat2(const std::string& name, const glm::mat2& mat) const;
+    void setMat2(int location, const glm::mat2& mat) const;
 
     void setMat3(const std::string& name, const glm::mat3& mat) const;
+    void setMat3(int location, const glm::mat3& mat) const;
 
     void setMat4(const std::string& name, const glm::mat4& mat) const;
+    void setMat4(int location, const glm::mat4& mat) const;
 
 private:
     constexpr static const int BUFFER_SIZE = 1024;
@@ -51,7 +77,13 @@ private:
 
     unsigned int mID;
 
+    /// Active uniforms reflected once after linking.
+    std::unordered_map<std::string, int> mUniformLocations;
+
+    static LookupCounters sLookupCounters;
+
     void checkCompileErrors(unsigned int shader, SHADER_TYPE type);
+    void reflectUniforms();
 };
 
 #endif // SHADER_HPP
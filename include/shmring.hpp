@@ -0,0 +1,117 @@
+#ifndef SHMRING_HPP
+#define SHMRING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <trajectorystream.hpp>
+
+/**
+ * Shared-memory ring of trajectory points between simulator and viewer
+ * on the same machine. POSIX segment holds Header followed by capacity
+ * float3 records. Producer advances write cursor after filling records,
+ * consumer advances read cursor after copying them out. Cursors count
+ * records since start and are atomics in shared memory, so no system
+ * call is made per batch.
+ */
+namespace ShmRing
+{
+
+/// Trajectory argument "shm:/name" names segment /name.
+const char PREFIX[] = "shm:";
+
+/// "ASHM" read as little-endian word.
+const uint32_t MAGIC = 0x4d485341;
+const uint32_t VERSION = 1;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "Shared cursors need lock-free atomics");
+
+struct Header
+{
+    /// Published last by producer, so it guards the other fields.
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    /// Number of records, power of two.
+    uint64_t capacity;
+    uint64_t recordSize;
+    uint64_t dataOffset;
+
+    /// Each cursor is written by one side only, on own cache line.
+    alignas(64) std::atomic<uint64_t> writeCursor;
+    alignas(64) std::atomic<uint64_t> readCursor;
+    /// Set by producer after its last record.
+    alignas(64) std::atomic<uint32_t> closed;
+};
+
+bool hasPrefix(const std::string& trajectory);
+
+/// Segment name of trajectory argument, e.g. "shm:lorenz" is "/lorenz".
+std::string segmentName(const std::string& trajectory);
+
+}
+
+/// Simulator side: creates segment and writes points into it.
+class ShmRingProducer
+{
+public:
+    ShmRingProducer(const std::string& name, size_t capacity);
+    ~ShmRingProducer();
+
+    ShmRingProducer(const ShmRingProducer&) = delete;
+    ShmRingProducer& operator=(const ShmRingProducer&) = delete;
+
+    /// Copy points in, waiting while ring is full.
+    void write(const glm::vec3* points, size_t count);
+
+    /// No more points will be written.
+    void close();
+
+    /// Reader has taken all written points.
+    bool isDrained() const;
+
+private:
+    std::string mName;
+    size_t mSize;
+    ShmRing::Header* mHeader;
+    glm::vec3* mRecords;
+    uint64_t mCachedRead;
+};
+
+/**
+ * Viewer side, polled by render thread. Segment may be created
+ * by producer after reader, it is looked for on every poll until then.
+ */
+class ShmRingReader : public TrajectoryStream
+{
+public:
+    explicit ShmRingReader(const std::string& name);
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    virtual bool poll(Trajectory& points, size_t maxPoints) override;
+
+    /// Producer closed ring and all points are taken.
+    virtual bool isFinished() const override;
+
+    virtual std::string getError() const override;
+
+    virtual void cancel() override;
+
+private:
+    std::string mName;
+    size_t mSize;
+    ShmRing::Header* mHeader;
+    const glm::vec3* mRecords;
+    std::string mError;
+
+    bool attach();
+};
+
+#endif // SHMRING_HPP
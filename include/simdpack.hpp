@@ -0,0 +1,123 @@
+#ifndef SIMDPACK_HPP
+#define SIMDPACK_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SIMDPACK_SSE
+#include <immintrin.h>
+#endif
+
+/**
+ * N doubles processed by one instruction, so that kernels written once
+ * with +, - and * run on the widest vectors enabled at compile time
+ * (see ATTRACTOR_NATIVE_ARCH). DoublePack<1> is plain double and takes
+ * remainders. Functions without vector instruction, e.g. sin, go lane by lane.
+ */
+template <int N>
+struct DoublePack;
+
+template <>
+struct DoublePack<1>
+{
+    static const int SIZE = 1;
+    double v;
+
+    DoublePack() = default;
+    DoublePack(double s) : v(s) {}
+
+    static DoublePack load(const double* p) { return *p; }
+    void store(double* p) const { *p = v; }
+
+    friend DoublePack operator+(DoublePack a, DoublePack b) { return a.v + b.v; }
+    friend DoublePack operator-(DoublePack a, DoublePack b) { return a.v - b.v; }
+    friend DoublePack operator*(DoublePack a, DoublePack b) { return a.v * b.v; }
+};
+
+#ifdef SIMDPACK_SSE
+template <>
+struct DoublePack<2>
+{
+    static const int SIZE = 2;
+    __m128d v;
+
+    DoublePack() = default;
+    DoublePack(__m128d s) : v(s) {}
+    DoublePack(double s) : v(_mm_set1_pd(s)) {}
+
+    static DoublePack load(const double* p) { return _mm_loadu_pd(p); }
+    void store(double* p) const { _mm_storeu_pd(p, v); }
+
+    friend DoublePack operator+(DoublePack a, DoublePack b) { return _mm_add_pd(a.v, b.v); }
+    friend DoublePack operator-(DoublePack a, DoublePack b) { return _mm_sub_pd(a.v, b.v); }
+    friend DoublePack operator*(DoublePack a, DoublePack b) { return _mm_mul_pd(a.v, b.v); }
+};
+#endif
+
+#ifdef __AVX__
+template <>
+struct DoublePack<4>
+{
+    static const int SIZE = 4;
+    __m256d v;
+
+    DoublePack() = default;
+    DoublePack(__m256d s) : v(s) {}
+    DoublePack(double s) : v(_mm256_set1_pd(s)) {}
+
+    static DoublePack load(const double* p) { return _mm256_loadu_pd(p); }
+    void store(double* p) const { _mm256_storeu_pd(p, v); }
+
+    friend DoublePack operator+(DoublePack a, DoublePack b) { return _mm256_add_pd(a.v, b.v); }
+    friend DoublePack operator-(DoublePack a, DoublePack b) { return _mm256_sub_pd(a.v, b.v); }
+    friend DoublePack operator*(DoublePack a, DoublePack b) { return _mm256_mul_pd(a.v, b.v); }
+};
+#endif
+
+#ifdef __AVX512F__
+template <>
+struct DoublePack<8>
+{
+    static const int SIZE = 8;
+    __m512d v;
+
+    DoublePack() = default;
+    DoublePack(__m512d s) : v(s) {}
+    DoublePack(double s) : v(_mm512_set1_pd(s)) {}
+
+    static DoublePack load(const double* p) { return _mm512_loadu_pd(p); }
+    void store(double* p) const { _mm512_storeu_pd(p, v); }
+
+    friend DoublePack operator+(DoublePack a, DoublePack b) { return _mm512_add_pd(a.v, b.v); }
+    friend DoublePack operator-(DoublePack a, DoublePack b) { return _mm512_sub_pd(a.v, b.v); }
+    friend DoublePack operator*(DoublePack a, DoublePack b) { return _mm512_mul_pd(a.v, b.v); }
+};
+#endif
+
+#if defined(__AVX512F__)
+using WideDoublePack = DoublePack<8>;
+#elif defined(__AVX__)
+using WideDoublePack = DoublePack<4>;
+#elif defined(SIMDPACK_SSE)
+using WideDoublePack = DoublePack<2>;
+#else
+using WideDoublePack = DoublePack<1>;
+#endif
+
+inline DoublePack<1> sin(DoublePack<1> a)
+{
+    return std::sin(a.v);
+}
+
+template <int N>
+DoublePack<N> sin(DoublePack<N> a)
+{
+    double lanes[N];
+    a.store(lanes);
+    for (int i = 0; i < N; ++i)
+        lanes[i] = std::sin(lanes[i]);
+    return DoublePack<N>::load(lanes);
+}
+
+#endif // SIMDPACK_HPP
@@ -0,0 +1,121 @@
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Lock-free ring buffer for exactly one producer and one consumer thread.
+ * Each side caches the other's index and reloads it only when the ring
+ * looks full (empty), so that indices do not bounce between cores.
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    /// Capacity is rounded up to power of two.
+    explicit SpscRing(size_t capacity);
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const;
+
+    /// Producer: copy up to count items in, returns number copied.
+    size_t push(const T* items, size_t count);
+
+    /// Consumer: copy up to count items out, returns number copied.
+    size_t pop(T* items, size_t count);
+
+    /// Consumer: no items are available.
+    bool empty() const;
+
+private:
+    constexpr static const size_t CACHE_LINE = 64;
+
+    std::vector<T> mItems;
+    size_t mMask;
+
+    /// Written by producer.
+    char mPadHead[CACHE_LINE];
+    std::atomic<size_t> mHead;
+    size_t mCachedTail;
+
+    /// Written by consumer.
+    char mPadTail[CACHE_LINE];
+    std::atomic<size_t> mTail;
+    size_t mCachedHead;
+    char mPadEnd[CACHE_LINE];
+};
+
+template <typename T>
+SpscRing<T>::SpscRing(size_t capacity)
+    : mHead(0)
+    , mCachedTail(0)
+    , mTail(0)
+    , mCachedHead(0)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    mItems.resize(size);
+    mMask = size - 1;
+}
+
+template <typename T>
+size_t SpscRing<T>::capacity() const
+{
+    return mItems.size();
+}
+
+template <typename T>
+size_t SpscRing<T>::push(const T* items, size_t count)
+{
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    if (capacity() - (head - mCachedTail) < count)
+        mCachedTail = mTail.load(std::memory_order_acquire);
+
+    count = std::min(count, capacity() - (head - mCachedTail));
+    if (count == 0)
+        return 0;
+
+    /// Free space may wrap around the end of storage.
+    const size_t first = std::min(count, capacity() - (head & mMask));
+    std::copy(items, items + first, mItems.begin() + (head & mMask));
+    std::copy(items + first, items + count, mItems.begin());
+
+    mHead.store(head + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T>
+size_t SpscRing<T>::pop(T* items, size_t count)
+{
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (mCachedHead - tail < count)
+        mCachedHead = mHead.load(std::memory_order_acquire);
+
+    count = std::min(count, mCachedHead - tail);
+    if (count == 0)
+        return 0;
+
+    const size_t first = std::min(count, capacity() - (tail & mMask));
+    std::copy(mItems.begin() + (tail & mMask),
+              mItems.begin() + (tail & mMask) + first, items);
+    std::copy(mItems.begin(), mItems.begin() + (count - first), items + first);
+
+    mTail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T>
+bool SpscRing<T>::empty() const
+{
+    return mHead.load(std::memory_order_acquire) ==
+           mTail.load(std::memory_order_relaxed);
+}
+
+#endif // SPSCRING_HPP
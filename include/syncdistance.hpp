@@ -0,0 +1,70 @@
+#ifndef SYNCDISTANCE_HPP
+#define SYNCDISTANCE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <trajectory.hpp>
+
+/**
+ * Synchronization error of two trajectories: distance between their
+ * points at every aligned time index, computed with SIMD on thread pool.
+ * Distances are kept, so thresholded views (divergence, synchronized
+ * fraction, hidden segments) change with threshold without recomputing them.
+ *
+ * With lag L, distance k is between first[k + firstOffset] and
+ * second[k + secondOffset], where the offset of the later trajectory
+ * is |L|. Only the overlap of both trajectories has distances.
+ */
+class SyncDistance
+{
+public:
+    SyncDistance();
+
+    /// Second trajectory is ahead of first by lag points, distances are recomputed.
+    void setLag(ptrdiff_t lag);
+    ptrdiff_t getLag() const;
+    size_t getFirstOffset() const;
+    size_t getSecondOffset() const;
+
+    /// Either trajectory was replaced, not only continued.
+    void invalidate();
+
+    /**
+     * Trajectories must continue those of previous update unless
+     * invalidate() was called in between. Distances of new aligned
+     * points are appended, returns true if there are any.
+     */
+    bool update(const Trajectory& first, const Trajectory& second);
+
+    const std::vector<float>& getDistances() const;
+    size_t size() const;
+
+    /// Index of first distance above threshold, size() if there is none.
+    size_t firstDivergence(float threshold) const;
+    /// Part of distances not above threshold.
+    double synchronizedFraction(float threshold) const;
+
+    /**
+     * Lag in [-maxLag, maxLag] with smallest mean distance over first
+     * window aligned points, e.g. to align trajectories started at
+     * different phases.
+     */
+    static ptrdiff_t estimateLag(const Trajectory& first, const Trajectory& second,
+                                 size_t maxLag, size_t window);
+
+    /// Distances of n point pairs, 4 at once if SSE is available.
+    static void distances(const glm::vec3* first, const glm::vec3* second,
+                          float* out, size_t n);
+
+private:
+    /// Points per task of parallel computation.
+    static const size_t GRAIN = 1 << 16;
+
+    ptrdiff_t mLag;
+    std::vector<float> mDistances;
+};
+
+#endif // SYNCDISTANCE_HPP
@@ -0,0 +1,70 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int nThreads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Pool shared by the whole application.
+    static ThreadPool& instance();
+
+    unsigned int getNThreads() const;
+
+    /// Run task on a worker.
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<decltype(function())>;
+
+    /**
+     * Split [begin, end) into chunks of at most grain elements and call
+     * body(chunkBegin, chunkEnd) for each of them in parallel.
+     * Calling thread takes part in work, so it is safe to call from a worker.
+     * First exception thrown by body is rethrown here after all chunks
+     * already started are finished.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain,
+                     const std::function<void(size_t, size_t)>& body);
+
+private:
+    std::vector<std::thread> mWorkers;
+    std::queue<std::function<void()>> mTasks;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
+
+template <typename Function>
+auto ThreadPool::submit(Function&& function) -> std::future<decltype(function())>
+{
+    using Result = decltype(function());
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Function>(function));
+    std::future<Result> result = task->get_future();
+
+    enqueue([task]() { (*task)(); });
+
+    return result;
+}
+
+#endif // THREADPOOL_HPP
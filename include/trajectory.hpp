@@ -0,0 +1,45 @@
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * Sequence of trajectory points. Points are either owned or live in
+ * external storage (e.g. mapped file) kept alive by the view.
+ * Copies share points, appending to shared points copies them first.
+ */
+class Trajectory
+{
+public:
+    Trajectory();
+    Trajectory(std::vector<glm::vec3> points);
+    Trajectory(std::shared_ptr<const void> storage,
+               const glm::vec3* points, size_t size);
+
+    const glm::vec3* data() const;
+    size_t size() const;
+    bool empty() const;
+
+    const glm::vec3& operator[](size_t idx) const;
+
+    const glm::vec3* begin() const;
+    const glm::vec3* end() const;
+
+    /// View of count points from idx sharing the same storage.
+    Trajectory slice(size_t idx, size_t count) const;
+
+    /// Tail continuing this view in the same storage is joined without copy.
+    void append(const Trajectory& tail);
+
+private:
+    /// Either owned points or external storage is set.
+    std::shared_ptr<std::vector<glm::vec3>> mOwned;
+    std::shared_ptr<const void> mStorage;
+    const glm::vec3* mPoints;
+    size_t mSize;
+};
+
+#endif // TRAJECTORY_HPP
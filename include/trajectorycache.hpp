@@ -0,0 +1,75 @@
+#ifndef TRAJECTORYCACHE_HPP
+#define TRAJECTORYCACHE_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <trajectory.hpp>
+
+/**
+ * Binary cache of parsed point text files.
+ * After first parse points are written as .atrj file together with
+ * identity (size, mtime and content hash) of source files. Next loads map
+ * this file instead of parsing while identity still matches.
+ */
+class TrajectoryCache
+{
+public:
+    TrajectoryCache();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /// Empty directory means sidecar file next to source files.
+    std::string getDirectory() const;
+    void setDirectory(std::string directory);
+
+    /// Compare content hashes in addition to size and mtime.
+    bool getVerifyContent() const;
+    void setVerifyContent(bool verify);
+
+    Trajectory readPoints(const std::string& xFile,
+                          const std::string& yFile,
+                          const std::string& zFile) const;
+    std::vector<glm::vec2> readPoints(const std::string& xFile,
+                                      const std::string& yFile) const;
+
+    /**
+     * Streaming variant: cached points are passed to sink at once,
+     * otherwise parsed blocks are passed as they come and cache is written
+     * after the last one. Sink returns false to stop reading.
+     */
+    void readPoints(const std::string& xFile,
+                    const std::string& yFile,
+                    const std::string& zFile,
+                    const std::function<bool(Trajectory)>& sink) const;
+
+private:
+    constexpr static const char* SIDECAR_SUFFIX = ".cache";
+
+    bool mEnabled;
+    bool mVerifyContent;
+    std::string mDirectory;
+
+    std::string getCacheFileName(const std::vector<std::string>& sources) const;
+
+    /// Cache file name if it is up to date, empty string otherwise.
+    std::string findValid(const std::vector<std::string>& sources) const;
+
+    /**
+     * Serialized identities of sources, empty if cache is disabled.
+     * Taken before parsing, so file changed meanwhile is cached with its
+     * old identity and parsed again on next load.
+     */
+    std::string identifySources(const std::vector<std::string>& sources) const;
+
+    template <typename Point>
+    void store(const std::vector<std::string>& sources,
+               const std::string& metadata,
+               const Point* points, size_t count) const;
+};
+
+#endif // TRAJECTORYCACHE_HPP
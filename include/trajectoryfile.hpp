@@ -0,0 +1,67 @@
+#ifndef TRAJECTORYFILE_HPP
+#define TRAJECTORYFILE_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <trajectory.hpp>
+
+/**
+ * Binary trajectory format (.atrj), little-endian:
+ * 64-byte header, optional metadata text and, starting at dataOffset,
+ * count * dimension interleaved components.
+ * Float32 data with dimension 3 is mapped and used in place.
+ */
+namespace TrajectoryFile
+{
+
+const char EXTENSION[] = ".atrj";
+const uint32_t VERSION = 1;
+
+struct Header
+{
+    char     magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint32_t dimension;
+    /// Bytes per component: 4 (float) or 8 (double).
+    uint32_t precision;
+    float    boundsMin[3];
+    float    boundsMax[3];
+    uint64_t dataOffset;
+    /// Free-form text right after header.
+    uint64_t metadataSize;
+};
+
+static_assert(sizeof(Header) == 64, "Trajectory header must be 64 bytes");
+
+Header readHeader(const std::string& fileName);
+std::string readMetadata(const std::string& fileName);
+
+/// Map file and return its points, converting double data to float.
+Trajectory read(const std::string& fileName);
+
+/// Points of two-dimensional file, e.g. section shape.
+std::vector<glm::vec2> readPoints2D(const std::string& fileName);
+
+void write(const std::string& fileName, const glm::vec3* points, size_t count,
+           const std::string& metadata = std::string());
+void write(const std::string& fileName, const glm::vec2* points, size_t count,
+           const std::string& metadata = std::string());
+
+/// Write components given as separate axes, z may be empty for 2D data.
+void write(const std::string& fileName,
+           const std::vector<double>& x,
+           const std::vector<double>& y,
+           const std::vector<double>& z,
+           uint32_t precision);
+
+bool hasExtension(const std::string& fileName);
+
+}
+
+#endif // TRAJECTORYFILE_HPP
@@ -0,0 +1,47 @@
+#ifndef TRAJECTORYLOADER_HPP
+#define TRAJECTORYLOADER_HPP
+
+#include <functional>
+#include <string>
+
+#include <backgroundjob.hpp>
+#include <trajectory.hpp>
+#include <trajectorystream.hpp>
+
+/**
+ * Loads trajectory on background thread and hands it to render thread
+ * in parts, so that drawing starts before the whole trajectory is read.
+ */
+class TrajectoryLoader : public TrajectoryStream
+{
+public:
+    /// Passes loaded part, returns false when loading should stop.
+    using Sink = std::function<bool(Trajectory)>;
+    /// Reads trajectory passing its parts to sink in order.
+    using Source = std::function<void(const Sink&)>;
+
+    explicit TrajectoryLoader(Source source);
+    ~TrajectoryLoader();
+
+    TrajectoryLoader(const TrajectoryLoader&) = delete;
+    TrajectoryLoader& operator=(const TrajectoryLoader&) = delete;
+
+    virtual bool poll(Trajectory& points, size_t maxPoints) override;
+
+    /// Source is finished and all its points are taken.
+    virtual bool isFinished() const override;
+
+    /// Message of exception thrown by source, empty if there is none.
+    virtual std::string getError() const override;
+
+    /// Stop source at its next part and wait for it.
+    virtual void cancel() override;
+
+private:
+    /// Rest of large part taken from job, render thread only.
+    Trajectory mPart;
+
+    BackgroundJob<Trajectory> mJob;
+};
+
+#endif // TRAJECTORYLOADER_HPP
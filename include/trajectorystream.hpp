@@ -0,0 +1,30 @@
+#ifndef TRAJECTORYSTREAM_HPP
+#define TRAJECTORYSTREAM_HPP
+
+#include <string>
+
+#include <trajectory.hpp>
+
+/// Trajectory arriving over time, consumed by render thread.
+class TrajectoryStream
+{
+public:
+    virtual ~TrajectoryStream() = default;
+
+    /**
+     * Take next arrived points, at most maxPoints of them.
+     * Returns false if nothing arrived since last call.
+     */
+    virtual bool poll(Trajectory& points, size_t maxPoints) = 0;
+
+    /// No more points will arrive and all of them are taken.
+    virtual bool isFinished() const = 0;
+
+    /// Message of failure, empty if there is none.
+    virtual std::string getError() const = 0;
+
+    /// Stop producing points and wait for it.
+    virtual void cancel() = 0;
+};
+
+#endif // TRAJECTORYSTREAM_HPP
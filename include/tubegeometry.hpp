@@ -0,0 +1,83 @@
+#ifndef TUBEGEOMETRY_HPP
+#define TUBEGEOMETRY_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/// Section plane at trajectory point, spanned by p1 and p2.
+struct TubeFrame
+{
+    glm::vec3 p1;
+    glm::vec3 p2;
+};
+
+namespace TubeGeometry
+{
+
+/**
+ * Write nSection ring vertices for every frame into rings:
+ * rings[f*nSection + i] = positions[f] + radius*(section[i].x*p1 + section[i].y*p2).
+ * Section sizes of shipped shapes (4 and 16) have unrolled SIMD kernels.
+ */
+void generateRings(const glm::vec3* positions,
+                   const TubeFrame* frames, size_t nFrames,
+                   const glm::vec2* section, GLsizei nSection,
+                   GLfloat radius, glm::vec3* rings);
+
+/// Plain one vertex at a time version, reference for benchmarks.
+void generateRingsScalar(const glm::vec3* positions,
+                         const TubeFrame* frames, size_t nFrames,
+                         const glm::vec2* section, GLsizei nSection,
+                         GLfloat radius, glm::vec3* rings);
+
+/// Tangent of trajectory with no two distinct points.
+const glm::vec3 DEFAULT_TANGENT(0.0f, 0.0f, 1.0f);
+
+/**
+ * Unit tangent at point idx: central difference, one-sided at the ends.
+ * Degenerate difference of repeated points gives previous, so callers
+ * carry the last valid tangent forward.
+ */
+inline glm::vec3 tangent(const glm::vec3* points, GLsizei nPoints, GLsizei idx,
+                         const glm::vec3& previous)
+{
+    glm::vec3 d = points[std::min(idx + 1, nPoints - 1)] -
+                  points[std::max(idx - 1, 0)];
+    GLfloat length = glm::length(d);
+    return length > 0.0f ? d / length : previous;
+}
+
+/// Unit perpendicular of first tangent, start of transported frames.
+inline glm::vec3 initialNormal(const glm::vec3& t)
+{
+    glm::vec3 r = glm::cross(t, glm::vec3(1.0f, 0.0f, 0.0f));
+    if ( glm::dot(r, r) < 0.3f )
+        r = glm::cross(t, glm::vec3(0.0f, 1.0f, 0.0f));
+    return glm::normalize(r);
+}
+
+/**
+ * Double reflection (Wang et al. 2008) moving vector x from point p0
+ * with tangent t0 to point p1 with tangent t1. Linear in x.
+ */
+inline glm::vec3 transport(const glm::vec3& p0, const glm::vec3& p1,
+                           const glm::vec3& t0, const glm::vec3& t1,
+                           const glm::vec3& x)
+{
+    auto reflect = [](const glm::vec3& v, GLfloat c, const glm::vec3& y)
+    {
+        return c > 0.0f ? y - (2.0f / c) * glm::dot(v, y) * v : y;
+    };
+
+    glm::vec3 v1 = p1 - p0;
+    GLfloat c1 = glm::dot(v1, v1);
+    glm::vec3 v2 = t1 - reflect(v1, c1, t0);
+    return reflect(v2, glm::dot(v2, v2), reflect(v1, c1, x));
+}
+
+}
+
+#endif // TUBEGEOMETRY_HPP
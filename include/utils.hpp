@@ -2,16 +2,54 @@
 #define UTILS_HPP
 
 #include <fstream>
+#include <functional>
 #include <stdexcept>
 
 #include <vector>
 #include <string>
 
+#include <glm/glm.hpp>
+
 namespace Utils
 {
 
+/**
+ * Text files hold one number per line, blank lines are skipped.
+ * Files are mapped and parsed in parallel line-aligned chunks;
+ * malformed lines and axes of different length throw runtime_error.
+ */
 std::vector<double> readPoints(std::string fileName);
 
+std::vector<glm::vec2> readPoints(const std::string& xFile,
+                                  const std::string& yFile);
+
+std::vector<glm::vec3> readPoints(const std::string& xFile,
+                                  const std::string& yFile,
+                                  const std::string& zFile);
+
+/**
+ * Streaming variant: files are parsed block by block and points read
+ * from all files so far are passed to sink in order, so memory and time
+ * before the first call do not depend on file length.
+ * Sink returns false to stop reading.
+ */
+void readPoints(const std::string& xFile,
+                const std::string& yFile,
+                const std::string& zFile,
+                const std::function<bool(const glm::vec3*, size_t)>& sink);
+
+/**
+ * Parse line of numbers separated by blanks or commas into values.
+ * Returns number of values, -1 for malformed line or more than maxValues.
+ */
+int parseValues(const char* begin, const char* end,
+                double* values, int maxValues);
+
+bool fileExists(const std::string& fileName);
+
+/// Named pipe (FIFO).
+bool isPipe(const std::string& fileName);
+
 }
 
 #endif // UTILS_HPP
@@ -0,0 +1,13 @@
+#version 330 core
+
+in float shade;
+
+uniform vec4 color;
+uniform vec4 far_color;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = mix(color, far_color, shade);
+}
@@ -0,0 +1,52 @@
+#version 330 core
+
+const int MAX_SECTION_VERTICES = 64;
+
+/// One instance per segment: frames at its bottom and top points.
+layout (location = 0) in vec3 bottom_pos;
+layout (location = 1) in vec3 bottom_p1;
+layout (location = 2) in vec3 bottom_p2;
+layout (location = 3) in vec3 top_pos;
+layout (location = 4) in vec3 top_p1;
+layout (location = 5) in vec3 top_p2;
+/// Distance of bottom point, see AttractorModel::setDistances.
+layout (location = 6) in float distance;
+
+uniform vec4 trans_0;
+uniform vec4 trans_1;
+uniform vec4 trans_2;
+uniform vec4 trans_3;
+
+uniform float radius;
+uniform int section_size;
+uniform vec2 section[MAX_SECTION_VERTICES];
+uniform float threshold;
+uniform float distance_scale;
+
+/// Part of way from color to far color, see AttractorModel::setDistanceColors.
+out float shade;
+
+void main()
+{
+    shade = distance_scale > 0.0f ? clamp(distance / distance_scale, 0.0f, 1.0f) : 0.0f;
+
+    /// Hidden segment collapses into one point out of view.
+    if (threshold >= 0.0f && distance <= threshold)
+    {
+        gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
+        return;
+    }
+
+    /// Closed strip: bottom and top ring vertices interleaved.
+    int ring_idx = (gl_VertexID / 2) % section_size;
+    vec2 offset = radius * section[ring_idx];
+
+    vec3 pos;
+    if ((gl_VertexID & 1) == 0)
+        pos = bottom_pos + offset.x * bottom_p1 + offset.y * bottom_p2;
+    else
+        pos = top_pos + offset.x * top_p1 + offset.y * top_p2;
+
+    mat4 transform = mat4(trans_0, trans_1, trans_2, trans_3);
+    gl_Position = transform * vec4(pos, 1.0f);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+in float hidden;
+in float shade;
+
+uniform vec4 color;
+uniform vec4 far_color;
+
+out vec4 FragColor;
+
+void main()
+{
+    /// Half of segment next to hidden point is hidden too.
+    if (hidden > 0.5f)
+        discard;
+    FragColor = mix(color, far_color, shade);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+
+layout (location = 0) in vec3 pos;
+
+uniform vec4 trans_0;
+uniform vec4 trans_1;
+uniform vec4 trans_2;
+uniform vec4 trans_3;
+
+/// Distance of every trajectory point, see AttractorModel::setDistances.
+uniform samplerBuffer distances;
+uniform int section_size;
+uniform float threshold;
+uniform float distance_scale;
+
+out float hidden;
+/// Part of way from color to far color, see AttractorModel::setDistanceColors.
+out float shade;
+
+void main()
+{
+    /// Mesh holds one ring of section_size vertices per point.
+    float distance = texelFetch(distances, gl_VertexID / section_size).r;
+    hidden = (threshold >= 0.0f && distance <= threshold) ? 1.0f : 0.0f;
+    shade = distance_scale > 0.0f ? clamp(distance / distance_scale, 0.0f, 1.0f) : 0.0f;
+
+    mat4 transform = mat4(trans_0, trans_1, trans_2, trans_3);
+    gl_Position = transform * vec4(pos, 1.0f);
+}
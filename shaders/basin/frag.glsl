@@ -0,0 +1,25 @@
+#version 330 core
+
+in vec2 slice_coord;
+
+out vec4 FragColor;
+
+uniform sampler2D labels;
+
+uniform vec4 first_color;
+uniform vec4 second_color;
+uniform vec4 diverged_color;
+
+void main()
+{
+    /// Labels are stored as normalized bytes, see BasinMap::Label.
+    int label = int( texture(labels, slice_coord).r * 255.0f + 0.5f );
+    if ( label == 1 )
+        FragColor = first_color;
+    else if ( label == 2 )
+        FragColor = second_color;
+    else if ( label == 3 )
+        FragColor = diverged_color;
+    else
+        discard;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+out vec2 slice_coord;
+
+uniform vec4 trans_0;
+uniform vec4 trans_1;
+uniform vec4 trans_2;
+uniform vec4 trans_3;
+
+uniform vec3 origin;
+uniform vec3 axis_u;
+uniform vec3 axis_v;
+
+void main()
+{
+    uint idx = uint( gl_VertexID );
+    slice_coord = vec2( idx & 1U, idx >> 1U );
+
+    mat4 transform = mat4(trans_0, trans_1, trans_2, trans_3);
+    vec3 pos = origin + slice_coord.x * axis_u + slice_coord.y * axis_v;
+    gl_Position = transform * vec4(pos, 1.0f);
+}
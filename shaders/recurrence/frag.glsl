@@ -0,0 +1,23 @@
+#version 330 core
+
+in vec2 plot_coord;
+in vec2 tex_coord;
+
+out vec4 FragColor;
+
+uniform sampler2DArray rates;
+uniform int layer;
+
+uniform vec4 recurrent_color;
+uniform vec4 background_color;
+
+void main()
+{
+    /// Last tiles reach past end of trajectories.
+    if ( plot_coord.x > 1.0f || plot_coord.y > 1.0f )
+        discard;
+
+    /// Rates are stored as normalized bytes, see RecurrencePlot::Tile.
+    float rate = texture( rates, vec3(tex_coord, layer) ).r;
+    FragColor = mix( background_color, recurrent_color, rate );
+}
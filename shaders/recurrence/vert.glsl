@@ -0,0 +1,24 @@
+#version 330 core
+
+out vec2 plot_coord;
+out vec2 tex_coord;
+
+uniform vec4 trans_0;
+uniform vec4 trans_1;
+uniform vec4 trans_2;
+uniform vec4 trans_3;
+
+/// Corners of drawn part of tile in plot and in its texture layer.
+uniform vec4 rect;
+uniform vec4 tex_rect;
+
+void main()
+{
+    uint idx = uint( gl_VertexID );
+    vec2 corner = vec2( idx & 1U, idx >> 1U );
+    plot_coord = mix( rect.xy, rect.zw, corner );
+    tex_coord = mix( tex_rect.xy, tex_rect.zw, corner );
+
+    mat4 transform = mat4(trans_0, trans_1, trans_2, trans_3);
+    gl_Position = transform * vec4(plot_coord, 0.0f, 1.0f);
+}
@@ -6,6 +6,8 @@ std::unique_ptr<FpsManager> AttractorGLApp::sFpsManager = std::make_unique<FpsMa
 AttractorGLApp::AttractorGLApp(
         GLint width, GLint height, const std::string& title)
     : IGLApp(width, height, title)
+    , mFrameLookups({ 0, 0 })
+    , mReportLookups(false)
     , mAttractorFilter(AttractorFilter::BOTH)
     , mTimeDiff(1.0f)
     , mRadius(0.01f)
@@ -14,8 +16,27 @@ AttractorGLApp::AttractorGLApp(
     , mFirstAttractorSection("heart/")
     , mSecondAttractorTrajectory("coullet_2/")
     , mSecondAttractorSection("square/")
+    , mEnsemblesCancelled(false)
+    , mSystemParameter(0)
+    , mSystemParameterKeyPressed(false)
+    , mLyapunovPending(false)
+    , mLyapunovReportTime(0.0)
+    , mPoincareDirection(PoincareSection::UPWARD)
+    , mSyncLagEstimated(false)
+    , mDistanceThreshold(DISTANCE_THRESHOLD)
+    , mDistanceThresholdKeyPressed(false)
+    , mSyncUploadedEnd(0)
+    , mDistancesEnabled(true)
+    , mNearestApproach(false)
+    , mNearestPending(false)
+    , mNearestStartTime(0.0)
+    , mNearestCancelled(false)
+    , mRecurrence(false)
+    , mRecurrencePending(false)
+    , mRecurrenceSource(AttractorFilter::FIRST)
 {
-
+    /// Estimation is off until exponents are requested.
+    mLyapunovSettings.nExponents = 0;
 }
 
 void AttractorGLApp::configureApp()
@@ -43,36 +64,106 @@ void AttractorGLApp::configureApp()
     /// First attractor.
     mFirstAttractorTime = 0;
     mFirstAttractor = std::make_unique<AttractorModel>(
-            readAttractorVertices(trajectoriesDir +
-                                      mFirstAttractorTrajectory + "x.txt",
-                                  trajectoriesDir +
-                                      mFirstAttractorTrajectory + "y.txt",
-                                  trajectoriesDir +
-                                      mFirstAttractorTrajectory + "z.txt"),
+            Trajectory(),
             readSectionVertices(sectionsDir +
                                     mFirstAttractorSection + "x.txt",
                                 sectionsDir +
-                                    mFirstAttractorSection + "y.txt"));
+                                    mFirstAttractorSection + "y.txt"),
+            TubeMode::EXTRUDED, mResidencyBudget);
     mFirstAttractor->setColor(glm::vec4(1.0f, 0.0f, 0.0f, 0.67f));
     mFirstAttractor->setRadius(mRadius);
 
     /// Second attractor.
     mSecondAttractorTime = 0;
     mSecondAttractor = std::make_unique<AttractorModel>(
-            readAttractorVertices(trajectoriesDir +
-                                      mSecondAttractorTrajectory + "x.txt",
-                                  trajectoriesDir +
-                                      mSecondAttractorTrajectory + "y.txt",
-                                  trajectoriesDir +
-                                      mSecondAttractorTrajectory + "z.txt"),
+            Trajectory(),
             readSectionVertices(sectionsDir +
                                     mSecondAttractorSection + "x.txt",
                                 sectionsDir +
-                                    mSecondAttractorSection + "y.txt"));
+                                    mSecondAttractorSection + "y.txt"),
+            TubeMode::EXTRUDED, mResidencyBudget);
     mSecondAttractor->setColor(glm::vec4(0.0f, 0.0f, 1.0f, 0.67f));
     mSecondAttractor->setRadius(mRadius);
+    /// Distances of whole trajectories would not fit memory budgets.
+    mDistancesEnabled = !mFirstAttractor->isOutOfCore();
+    if (!mDistancesEnabled)
+    {
+        std::cout << "Out-of-core mode: synchronization distances and "
+                  << "nearest approach are off" << std::endl;
+        mNearestApproach = false;
+    }
+
+    /// Most points are near the other attractor somewhere, so nearest
+    /// approach hides them only once threshold is adjusted.
+    if (mDistancesEnabled && !mNearestApproach)
+        mSecondAttractor->setDistanceThreshold(mDistanceThreshold);
+
+    /// Trajectories are drawn as they load.
+    mFirstAttractorStream = loadAttractorTrajectory(trajectoriesDir,
+                                                    mFirstAttractorTrajectory);
+    mSecondAttractorStream = loadAttractorTrajectory(trajectoriesDir,
+                                                     mSecondAttractorTrajectory);
+    mFirstEnsembleResult = integrateEnsemble(mFirstAttractorTrajectory);
+    mSecondEnsembleResult = integrateEnsemble(mSecondAttractorTrajectory);
+
+    /// Basins are computed once both trajectories are loaded.
+    if (!mBasinSystem.empty())
+    {
+        try
+        {
+            OdeIntegrator::parse(mBasinSystem);
+        }
+        catch (std::runtime_error& exc)
+        {
+            std::cerr << exc.what() << std::endl;
+            stopBackgroundWork();
+            exit(-ERR_FILE_EXIST);
+        }
+    }
+
+    /// Lyapunov exponents are estimated once both trajectories are loaded.
+    if (mLyapunovSettings.nExponents > 0)
+    {
+        mLyapunovPending = true;
+        if (!mLyapunovSystem.empty())
+        {
+            try
+            {
+                OdeIntegrator::parse(mLyapunovSystem);
+            }
+            catch (std::runtime_error& exc)
+            {
+                std::cerr << exc.what() << std::endl;
+                stopBackgroundWork();
+                exit(-ERR_FILE_EXIST);
+            }
+        }
+    }
+
+    /// Nearest approach and recurrence plot wait for both trajectories.
+    mNearestPending = mNearestApproach;
+    mRecurrencePending = mRecurrence;
 
-    calculatePositionsToBeDrawnBoth();
+    /// Poincare sections follow trajectories as they load.
+    if (!mPoincareSurfaces.empty())
+    {
+        mFirstPoincare.setSurfaces(mPoincareSurfaces, mPoincareDirection);
+        mSecondPoincare.setSurfaces(mPoincareSurfaces, mPoincareDirection);
+
+        /// Crossings are brighter than tubes they lie on.
+        glm::vec4 firstColor = mFirstAttractor->getColor();
+        glm::vec4 secondColor = mSecondAttractor->getColor();
+        mFirstPoincareCloud = std::make_unique<PointCloudModel>();
+        mFirstPoincareCloud->setColor(glm::vec4(0.5f * (firstColor.r + 1.0f),
+                                                0.5f * (firstColor.g + 1.0f),
+                                                0.5f * (firstColor.b + 1.0f),
+                                                1.0f));
+        mSecondPoincareCloud = std::make_unique<PointCloudModel>();
+        mSecondPoincareCloud->setColor(glm::vec4(0.5f * (secondColor.r + 1.0f),
+                                                 0.5f * (secondColor.g + 1.0f),
+                                                 0.5f * (secondColor.b + 1.0f),
+                                                 1.0f));
+    }
 
     /// Background.
     configureBackground();
@@ -93,6 +184,42 @@ void AttractorGLApp::mainLoop()
         glfwPollEvents();
         processInput();
 
+        if (updateContinuations())
+        {
+            /// Trajectories are replaced, so distances are computed anew.
+            resetSyncDistance();
+
+            /// Estimates belong to previous parameters.
+            mLyapunovEstimator.reset();
+            mLyapunovPending = mLyapunovSettings.nExponents > 0;
+
+            /// Fields belong to previous trajectories.
+            if (mNearestApproach)
+            {
+                cancelNearestApproach();
+                mFirstAttractor->clearDistances();
+                mSecondAttractor->clearDistances();
+                mNearestPending = true;
+            }
+
+            /// Basins are classified by attractors, so they start over.
+            mBasinMap.reset();
+            mBasinModel.reset();
+
+            /// Plot of previous trajectories is dropped with its tiles.
+            mRecurrencePlot.reset();
+            mRecurrenceModel.reset();
+            mRecurrencePending = mRecurrence;
+        }
+        streamAttractorTrajectories();
+        updateSyncDistance();
+        updatePoincareSections();
+        collectEnsembles();
+        updateBasinMap();
+        updateLyapunovEstimator();
+        updateNearestApproach();
+        updateRecurrencePlot();
+
         /// Background.
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         drawBackgroundGradient(glm::vec3(0.4f, 0.4f, 0.4f),
@@ -100,44 +227,53 @@ void AttractorGLApp::mainLoop()
 
         /// Attractors.
         glm::mat4 projViewMat = mProjectionMat * sCamera->getViewMatrix();
-        for (GLsizei idx = 0; idx <= mFirstAttractorTime; ++idx)
-        {
-            auto draw = [&](GLsizei idx)
-            {
-                mFirstAttractor->draw(projViewMat, idx, 1);
-                if (mPositionsToBeDrawnBoth[idx])
-                {
-                    mSecondAttractor->draw(projViewMat, idx, 1);
-                }
-            };
-
-            /// Invert attractor's end color.
-            if (idx >= END_TIME)
-            {
-                auto firstColor = mFirstAttractor->getColor();
-                auto secondColor = mSecondAttractor->getColor();
-
-                mFirstAttractor->setColor(glm::vec4(1.0f - firstColor.r,
-                                                    1.0f - firstColor.g,
-                                                    1.0f - firstColor.b,
-                                                    firstColor.a));
-                mSecondAttractor->setColor(glm::vec4(1.0f - secondColor.r,
-                                                     1.0f - secondColor.g,
-                                                     1.0f - secondColor.b,
-                                                     secondColor.a));
-
-                draw(idx);
+        GLsizei nVisible = static_cast<GLsizei>(mFirstAttractorTime) + 1;
+        drawAttractors(projViewMat, 0, std::min(nVisible, GLsizei(END_TIME)));
 
-                mFirstAttractor->setColor(firstColor);
-                mSecondAttractor->setColor(secondColor);
+        /// Invert attractor's end color.
+        if (nVisible > END_TIME)
+        {
+            auto firstColor = mFirstAttractor->getColor();
+            auto secondColor = mSecondAttractor->getColor();
+
+            mFirstAttractor->setColor(glm::vec4(1.0f - firstColor.r,
+                                                1.0f - firstColor.g,
+                                                1.0f - firstColor.b,
+                                                firstColor.a));
+            mSecondAttractor->setColor(glm::vec4(1.0f - secondColor.r,
+                                                 1.0f - secondColor.g,
+                                                 1.0f - secondColor.b,
+                                                 secondColor.a));
+
+            drawAttractors(projViewMat, END_TIME, nVisible - END_TIME);
+
+            mFirstAttractor->setColor(firstColor);
+            mSecondAttractor->setColor(secondColor);
+        }
 
+        /// Crossings lie on tubes, so they are drawn after them.
+        for (auto* cloud : { mFirstPoincareCloud.get(), mSecondPoincareCloud.get() })
+        {
+            if (!cloud)
                 continue;
-            }
+            cloud->rotateTo(mRotation);
+            cloud->draw(projViewMat);
+        }
 
-            draw(idx);
+        /// Basins lie among attractors, so they are drawn after them.
+        if (mBasinModel)
+        {
+            mBasinModel->rotateTo(mRotation);
+            mBasinModel->draw(projViewMat);
         }
 
+        /// Recurrence plot covers scene in its corner.
+        drawRecurrencePlot();
+
         glfwSwapBuffers(mWindow);
+
+        if (mReportLookups)
+            reportUniformLookups();
     }
 
     terminate();
@@ -145,6 +281,14 @@ void AttractorGLApp::mainLoop()
 
 void AttractorGLApp::terminate()
 {
+    stopBackgroundWork();
+    mFirstEnsemble.reset();
+    mSecondEnsemble.reset();
+    mBasinModel.reset();
+    mRecurrenceModel.reset();
+    mFirstPoincareCloud.reset();
+    mSecondPoincareCloud.reset();
+
     glDeleteVertexArrays(1, &mBackgroundArrayObject);
 
     IGLApp::terminate();
@@ -202,6 +346,41 @@ void AttractorGLApp::processInputForAttractors()
     if (glfwGetKey(mWindow, GLFW_KEY_COMMA) == GLFW_PRESS)
         adjustAttractorColor(ColorComponent::ALPHA, false); /// DEC ALPHA.
 
+    /// System parameter continuation.
+    if (glfwGetKey(mWindow, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS)
+        adjustSystemParameter(true);
+    if (glfwGetKey(mWindow, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS)
+        adjustSystemParameter(false);
+    bool parameterKeyPressed = glfwGetKey(mWindow, GLFW_KEY_P) == GLFW_PRESS;
+    if (parameterKeyPressed && !mSystemParameterKeyPressed)
+        selectNextSystemParameter();
+    mSystemParameterKeyPressed = parameterKeyPressed;
+
+    /// Distance threshold adjusting, statistics are reported on release.
+    bool thresholdKeyPressed = false;
+    if (glfwGetKey(mWindow, GLFW_KEY_K) == GLFW_PRESS)
+    {
+        adjustDistanceThreshold(true);
+        thresholdKeyPressed = true;
+    }
+    if (glfwGetKey(mWindow, GLFW_KEY_J) == GLFW_PRESS)
+    {
+        adjustDistanceThreshold(false);
+        thresholdKeyPressed = true;
+    }
+    if (!thresholdKeyPressed && mDistanceThresholdKeyPressed)
+        reportSyncDistance();
+    mDistanceThresholdKeyPressed = thresholdKeyPressed;
+
+    /// Poincare surfaces shifting.
+    if (glfwGetKey(mWindow, GLFW_KEY_O) == GLFW_PRESS)
+        shiftPoincareSurfaces(true);
+    if (glfwGetKey(mWindow, GLFW_KEY_L) == GLFW_PRESS)
+        shiftPoincareSurfaces(false);
+
+    /// Recurrence plot zooming and panning.
+    adjustRecurrenceView();
+
     /// Time diff adjusting.
     if (glfwGetKey(mWindow, GLFW_KEY_F1) == GLFW_PRESS)
         if (++mTimeDiff > 100.0f) mTimeDiff = 100.0f;
@@ -286,43 +465,538 @@ void AttractorGLApp::configureBackground()
     glGenVertexArrays(1, &mBackgroundArrayObject);
 }
 
-std::vector<glm::vec3> AttractorGLApp::readAttractorVertices(
-        std::string xFile, std::string yFile, std::string zFile)
+std::unique_ptr<TrajectoryStream> AttractorGLApp::loadAttractorTrajectory(
+        const std::string& trajectoriesDir, const std::string& trajectory)
 {
-    try
+    /// Live points of running producer.
+    if (ShmRing::hasPrefix(trajectory))
+    {
+        return std::make_unique<ShmRingReader>(trajectory);
+    }
+    if (trajectory == PipeReader::STDIN_NAME || Utils::isPipe(trajectory))
+    {
+        try
+        {
+            return std::make_unique<PipeReader>(trajectory);
+        }
+        catch (std::runtime_error& exc)
+        {
+            std::cerr << exc.what() << std::endl;
+            stopBackgroundWork();
+            exit(-ERR_FILE_EXIST);
+        }
+    }
+
+    /// Built-in system integrated on background thread as points are drawn.
+    if (OdeIntegrator::hasPrefix(trajectory))
+    {
+        OdeIntegrator::Settings settings;
+        try
+        {
+            settings = OdeIntegrator::parse(trajectory);
+        }
+        catch (std::runtime_error& exc)
+        {
+            std::cerr << exc.what() << std::endl;
+            stopBackgroundWork();
+            exit(-ERR_FILE_EXIST);
+        }
+        return std::make_unique<TrajectoryLoader>(
+                [settings](const TrajectoryLoader::Sink& sink)
+        {
+            OdeIntegrator::integrate(settings, [&sink](std::vector<glm::vec3> points)
+            {
+                return sink(Trajectory(std::move(points)));
+            });
+        });
+    }
+
+    /// NumPy array is given by its path, optionally relative to trajectories.
+    if (NpyFile::hasExtension(trajectory))
+    {
+        std::string npyFile = Utils::fileExists(trajectory)
+                            ? trajectory
+                            : trajectoriesDir + trajectory;
+        return std::make_unique<TrajectoryLoader>(
+                [npyFile](const TrajectoryLoader::Sink& sink)
+        {
+            sink(NpyFile::read(npyFile));
+        });
+    }
+
+    /// Binary file may be given directly or lie next to text files.
+    std::string binaryFile = TrajectoryFile::hasExtension(trajectory)
+                           ? trajectory
+                           : trajectoriesDir + trajectory + "trajectory" +
+                             TrajectoryFile::EXTENSION;
+    if (!Utils::fileExists(binaryFile) &&
+        TrajectoryFile::hasExtension(trajectory))
+    {
+        binaryFile = trajectoriesDir + trajectory;
+    }
+
+    if (Utils::fileExists(binaryFile))
+    {
+        return std::make_unique<TrajectoryLoader>(
+                [binaryFile](const TrajectoryLoader::Sink& sink)
+        {
+            sink(TrajectoryFile::read(binaryFile));
+        });
+    }
+
+    /// Text files are parsed block by block.
+    std::string prefix = trajectoriesDir + trajectory;
+    const TrajectoryCache& cache = mTrajectoryCache;
+    return std::make_unique<TrajectoryLoader>(
+            [prefix, &cache](const TrajectoryLoader::Sink& sink)
+    {
+        cache.readPoints(prefix + "x.txt", prefix + "y.txt", prefix + "z.txt",
+                         sink);
+    });
+}
+
+bool AttractorGLApp::streamAttractorTrajectories()
+{
+    for (auto* stream : { &mFirstAttractorStream, &mSecondAttractorStream })
     {
-        std::vector<glm::vec3> vertices;
+        std::string error = *stream ? (*stream)->getError() : std::string();
+        if (!error.empty())
+        {
+            std::cerr << error << std::endl;
+            stopBackgroundWork();
+            exit(-ERR_FILE_EXIST);
+        }
+    }
+
+    bool appended = streamAttractorTrajectory(mFirstAttractorStream,
+                                              *mFirstAttractor);
+    appended |= streamAttractorTrajectory(mSecondAttractorStream,
+                                          *mSecondAttractor);
+    return appended;
+}
+
+bool AttractorGLApp::streamAttractorTrajectory(
+        std::unique_ptr<TrajectoryStream>& stream, AttractorModel& model)
+{
+    if (!stream)
+        return false;
+
+    /// Bounded work per frame keeps frame time independent of file length.
+    /// Out-of-core model only records appended points, so it takes all.
+    const size_t limit = model.isOutOfCore() ? SIZE_MAX : STREAM_POINTS_PER_FRAME;
+    Trajectory points;
+    size_t budget = limit;
+    while (budget > 0 && stream->poll(points, budget))
+    {
+        budget -= points.size();
+        model.appendVertices(points);
+    }
+
+    /// Error is reported by next call.
+    if (stream->isFinished() && stream->getError().empty())
+        stream.reset();
 
-        auto x = Utils::readPoints(xFile);
-        auto y = Utils::readPoints(yFile);
-        auto z = Utils::readPoints(zFile);
+    return budget != limit;
+}
+
+std::future<std::vector<glm::vec3>> AttractorGLApp::integrateEnsemble(
+        const std::string& trajectory)
+{
+    if (mEnsembleSettings.nTrajectories == 0 || !OdeIntegrator::hasPrefix(trajectory))
+        return std::future<std::vector<glm::vec3>>();
 
-        for ( GLsizei i = 0; i < x.size(); i++ )
-            vertices.emplace_back(x[i], y[i], z[i]);
+    /// Argument is already checked by loadAttractorTrajectory.
+    OdeIntegrator::Settings integration = OdeIntegrator::parse(trajectory);
+    Ensemble::Settings settings = mEnsembleSettings;
+    return ThreadPool::instance().submit([this, integration, settings]()
+    {
+        return Ensemble::integrate(integration, settings, mEnsemblesCancelled);
+    });
+}
 
-        return vertices;
+void AttractorGLApp::collectEnsembles()
+{
+    if (mFirstEnsembleResult.valid())
+    {
+        glm::vec4 color = mFirstAttractor->getColor();
+        mFirstEnsemble = collectEnsemble(mFirstEnsembleResult,
+                                         glm::vec4(color.r, color.g, color.b, 0.2f));
+    }
+    if (mSecondEnsembleResult.valid())
+    {
+        glm::vec4 color = mSecondAttractor->getColor();
+        mSecondEnsemble = collectEnsemble(mSecondEnsembleResult,
+                                          glm::vec4(color.r, color.g, color.b, 0.2f));
+    }
+}
+
+std::unique_ptr<EnsembleModel> AttractorGLApp::collectEnsemble(
+        std::future<std::vector<glm::vec3>>& result, const glm::vec4& color)
+{
+    if (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return nullptr;
+
+    std::vector<glm::vec3> points;
+    try
+    {
+        points = result.get();
     }
     catch (std::runtime_error& exc)
     {
         std::cerr << exc.what() << std::endl;
+        stopBackgroundWork();
         exit(-ERR_FILE_EXIST);
     }
+
+    auto ensemble = std::make_unique<EnsembleModel>(
+            std::move(points),
+            static_cast<GLsizei>(mEnsembleSettings.nTrajectories),
+            static_cast<GLsizei>(mEnsembleSettings.nPoints));
+    ensemble->setColor(color);
+    return ensemble;
 }
 
-std::vector<glm::vec2> AttractorGLApp::readSectionVertices(
-        std::string xFile, std::string yFile)
+void AttractorGLApp::cancelEnsembles()
 {
-    try
+    mEnsemblesCancelled = true;
+    for (auto* result : { &mFirstEnsembleResult, &mSecondEnsembleResult })
+    {
+        if (result->valid())
+            result->wait();
+    }
+}
+
+void AttractorGLApp::adjustSystemParameter(bool toIncrement)
+{
+    GLfloat factor = PARAMETER_RATE * mFpsTimeDelta;
+    if (!toIncrement)
+        factor = -factor;
+
+    adjustSystemParameter(mFirstAttractorTrajectory, mFirstContinuation,
+                          mFirstAttractorStream, *mFirstAttractor, factor);
+    adjustSystemParameter(mSecondAttractorTrajectory, mSecondContinuation,
+                          mSecondAttractorStream, *mSecondAttractor, factor);
+}
+
+void AttractorGLApp::adjustSystemParameter(
+        const std::string& trajectory,
+        std::unique_ptr<ParameterContinuation>& continuation,
+        std::unique_ptr<TrajectoryStream>& stream,
+        const AttractorModel& model, GLfloat factor)
+{
+    if (!OdeIntegrator::hasPrefix(trajectory))
+        return;
+
+    if (!continuation)
+    {
+        /// Shown trajectory is replaced, so its loading stops.
+        stream.reset();
+
+        OdeIntegrator::Settings settings = OdeIntegrator::parse(trajectory);
+        glm::dvec3 start = settings.system.initial;
+        const Trajectory& points = model.getTrajectoryVertices();
+        if (!points.empty())
+        {
+            const glm::vec3& last = points[points.size() - 1];
+            start = glm::dvec3(last.x, last.y, last.z) / settings.system.scale;
+        }
+        continuation = std::make_unique<ParameterContinuation>(settings, start);
+    }
+
+    const OdeSystem& system = continuation->getSettings().system;
+    const int idx = mSystemParameter % static_cast<int>(system.parameters.size());
+    /// Parameters near zero still change.
+    double value = system.parameters[idx];
+    value += factor * std::max(std::abs(value), 0.1);
+    continuation->setParameter(idx, value);
+}
+
+void AttractorGLApp::selectNextSystemParameter()
+{
+    ++mSystemParameter;
+
+    for (const auto& trajectory : { mFirstAttractorTrajectory, mSecondAttractorTrajectory })
+    {
+        if (!OdeIntegrator::hasPrefix(trajectory))
+            continue;
+
+        OdeSystem system = OdeIntegrator::parse(trajectory).system;
+        mSystemParameter %= static_cast<int>(system.parameterNames.size());
+        std::cout << "Parameter " << system.name << " "
+                  << system.parameterNames[mSystemParameter] << std::endl;
+        return;
+    }
+}
+
+bool AttractorGLApp::updateContinuations()
+{
+    bool firstSwapped = updateContinuation(mFirstContinuation, *mFirstAttractor);
+    bool secondSwapped = updateContinuation(mSecondContinuation, *mSecondAttractor);
+
+    /// Replaced trajectories are sectioned anew.
+    if (firstSwapped)
+        mFirstPoincare.invalidate();
+    if (secondSwapped)
+        mSecondPoincare.invalidate();
+
+    return firstSwapped || secondSwapped;
+}
+
+bool AttractorGLApp::updateContinuation(
+        std::unique_ptr<ParameterContinuation>& continuation,
+        AttractorModel& model)
+{
+    if (!continuation)
+        return false;
+
+    /// Failed run keeps previous trajectory shown.
+    std::string error;
+    if (continuation->takeError(error))
+        std::cerr << error << std::endl;
+
+    Trajectory points;
+    if (!continuation->poll(points))
+        return false;
+
+    model.setTrajectoryVertices(std::move(points));
+
+    const OdeSystem& system = continuation->getSettings().system;
+    std::cout << system.name;
+    for (size_t i = 0; i < system.parameters.size(); ++i)
+        std::cout << " " << system.parameterNames[i] << "=" << system.parameters[i];
+    std::cout << std::endl;
+
+    return true;
+}
+
+void AttractorGLApp::updateBasinMap()
+{
+    if (mBasinSystem.empty())
+        return;
+
+    if (!mBasinMap && !mBasinModel)
+    {
+        if (mFirstAttractorStream || mSecondAttractorStream)
+            return;
+
+        OdeIntegrator::Settings integration = OdeIntegrator::parse(mBasinSystem);
+        try
+        {
+            mBasinMap = std::make_unique<BasinMap>(
+                    integration, mBasinSettings,
+                    mFirstAttractor->getTrajectoryVertices(),
+                    mSecondAttractor->getTrajectoryVertices());
+        }
+        catch (std::runtime_error& exc)
+        {
+            std::cerr << exc.what() << std::endl;
+            stopBackgroundWork();
+            exit(-ERR_FILE_EXIST);
+        }
+
+        /// Slice square in drawn coordinates.
+        const float scale = static_cast<float>(integration.system.scale);
+        const float side = static_cast<float>(2.0 * mBasinSettings.halfSize) * scale;
+        glm::dvec3 origin(mBasinSettings.center.x - mBasinSettings.halfSize,
+                          mBasinSettings.center.y - mBasinSettings.halfSize,
+                          mBasinSettings.center.z);
+        mBasinModel = std::make_unique<BasinModel>(
+                mBasinSettings.resolution,
+                glm::vec3(origin.x * scale, origin.y * scale, origin.z * scale),
+                glm::vec3(side, 0.0f, 0.0f),
+                glm::vec3(0.0f, side, 0.0f));
+
+        glm::vec4 firstColor = mFirstAttractor->getColor();
+        glm::vec4 secondColor = mSecondAttractor->getColor();
+        mBasinModel->setColors(glm::vec4(firstColor.r, firstColor.g, firstColor.b, 0.4f),
+                               glm::vec4(secondColor.r, secondColor.g, secondColor.b, 0.4f),
+                               glm::vec4(0.0f, 0.0f, 0.0f, 0.4f));
+    }
+    if (!mBasinMap)
+        return;
+
+    std::string error = mBasinMap->getError();
+    if (!error.empty())
+    {
+        std::cerr << error << std::endl;
+        stopBackgroundWork();
+        exit(-ERR_FILE_EXIST);
+    }
+
+    BasinMap::Tile tile;
+    while (mBasinMap->poll(tile))
+        mBasinModel->updateTile(tile);
+
+    if (mBasinMap->isFinished())
+        mBasinMap.reset();
+}
+
+void AttractorGLApp::shiftPoincareSurfaces(bool toIncrement)
+{
+    if (mPoincareSurfaces.empty())
+        return;
+
+    GLfloat shift = POINCARE_RATE * mFpsTimeDelta;
+    if (!toIncrement)
+        shift = -shift;
+
+    for (auto& surface : mPoincareSurfaces)
     {
-        std::vector<glm::vec2> vertices;
+        /// Plane moves by shift whatever length of its normal is.
+        if (surface.kind == PoincareSection::Surface::PLANE)
+            surface.offset += shift * glm::length(surface.normal);
+        else
+            surface.offset = std::max(0.0f, surface.offset + shift);
+    }
+
+    /// Chunk bounds are kept, only crossings are recomputed.
+    mFirstPoincare.setSurfaces(mPoincareSurfaces, mPoincareDirection);
+    mSecondPoincare.setSurfaces(mPoincareSurfaces, mPoincareDirection);
+}
+
+void AttractorGLApp::updatePoincareSections()
+{
+    if (mPoincareSurfaces.empty())
+        return;
+
+    updatePoincareSection(mFirstPoincare, *mFirstAttractor, *mFirstPoincareCloud);
+    updatePoincareSection(mSecondPoincare, *mSecondAttractor, *mSecondPoincareCloud);
+}
 
-        auto x = Utils::readPoints(xFile);
-        auto y = Utils::readPoints(yFile);
+void AttractorGLApp::updatePoincareSection(PoincareSection& section,
+                                           const AttractorModel& model,
+                                           PointCloudModel& cloud)
+{
+    if (!section.update(model.getTrajectoryVertices()))
+        return;
 
-        for ( GLsizei i = 0; i < x.size(); i++ )
-            vertices.emplace_back(x[i], y[i]);
+    /// Crossings of all surfaces are drawn as one cloud.
+    mPoincarePoints.clear();
+    for (size_t i = 0; i < section.getSurfaces().size(); ++i)
+    {
+        const auto& crossings = section.getCrossings(i);
+        mPoincarePoints.insert(mPoincarePoints.end(), crossings.begin(), crossings.end());
+    }
+    cloud.setPoints(mPoincarePoints);
+}
 
-        return vertices;
+void AttractorGLApp::updateLyapunovEstimator()
+{
+    if (mLyapunovPending)
+    {
+        if (mFirstAttractorStream || mSecondAttractorStream)
+            return;
+        mLyapunovPending = false;
+
+        std::vector<LyapunovEstimator::Attractor> attractors;
+        mLyapunovNames.clear();
+        LyapunovEstimator::Attractor attractor;
+        if (lyapunovAttractor(mFirstAttractorTrajectory, mFirstContinuation,
+                              *mFirstAttractor, attractor))
+        {
+            attractors.push_back(attractor);
+            mLyapunovNames.push_back("first " + attractor.system.name);
+        }
+        if (lyapunovAttractor(mSecondAttractorTrajectory, mSecondContinuation,
+                              *mSecondAttractor, attractor))
+        {
+            attractors.push_back(attractor);
+            mLyapunovNames.push_back("second " + attractor.system.name);
+        }
+        if (attractors.empty())
+        {
+            std::cerr << "No system to estimate Lyapunov exponents of, "
+                         "see --lyapunov-system" << std::endl;
+            return;
+        }
+
+        mLyapunovEstimator = std::make_unique<LyapunovEstimator>(
+                std::move(attractors), mLyapunovSettings);
+        mLyapunovReportTime = glfwGetTime();
+    }
+    if (!mLyapunovEstimator)
+        return;
+
+    /// Diverged estimation is dropped, viewer goes on.
+    std::string error = mLyapunovEstimator->getError();
+    if (!error.empty())
+    {
+        std::cerr << error << std::endl;
+        mLyapunovEstimator.reset();
+        glfwSetWindowTitle(mWindow, mWindowTitle.c_str());
+        return;
+    }
+
+    /// Title is not updated every frame.
+    double time = glfwGetTime();
+    if (time - mLyapunovReportTime < LYAPUNOV_REPORT_PERIOD)
+        return;
+    mLyapunovReportTime = time;
+
+    std::ostringstream title;
+    title << mWindowTitle;
+    title.precision(3);
+    const char* separator = " | ";
+    std::vector<LyapunovEstimator::Estimate> estimates = mLyapunovEstimator->getEstimates();
+    for (size_t i = 0; i < estimates.size(); ++i)
+    {
+        if (estimates[i].exponents.empty())
+            continue;
+
+        title << separator << mLyapunovNames[i] << " L =";
+        separator = "; ";
+        for (double exponent : estimates[i].exponents)
+            title << " " << std::fixed << exponent;
+    }
+    glfwSetWindowTitle(mWindow, title.str().c_str());
+}
+
+bool AttractorGLApp::lyapunovAttractor(
+        const std::string& trajectory,
+        const std::unique_ptr<ParameterContinuation>& continuation,
+        const AttractorModel& model,
+        LyapunovEstimator::Attractor& attractor) const
+{
+    /// Continued system has current parameters.
+    if (continuation)
+        attractor.system = continuation->getSettings().system;
+    else if (OdeIntegrator::hasPrefix(trajectory))
+        attractor.system = OdeIntegrator::parse(trajectory).system;
+    else if (!mLyapunovSystem.empty())
+        attractor.system = OdeIntegrator::parse(mLyapunovSystem).system;
+    else
+        return false;
+
+    /// Last shown point is on attractor already.
+    attractor.start = attractor.system.initial;
+    const Trajectory& points = model.getTrajectoryVertices();
+    if (!points.empty())
+    {
+        const glm::vec3& last = points[points.size() - 1];
+        attractor.start = glm::dvec3(last.x, last.y, last.z) / attractor.system.scale;
+    }
+    return true;
+}
+
+void AttractorGLApp::stopBackgroundWork()
+{
+    mFirstAttractorStream.reset();
+    mSecondAttractorStream.reset();
+    mFirstContinuation.reset();
+    mSecondContinuation.reset();
+    cancelEnsembles();
+    mBasinMap.reset();
+    mLyapunovEstimator.reset();
+    cancelNearestApproach();
+    mRecurrencePlot.reset();
+}
+
+std::vector<glm::vec2> AttractorGLApp::readSectionVertices(
+        std::string xFile, std::string yFile)
+{
+    try
+    {
+        return mTrajectoryCache.readPoints(xFile, yFile);
     }
     catch (std::runtime_error& exc)
     {
@@ -454,19 +1128,275 @@ void AttractorGLApp::drawBackgroundGradient(const glm::vec3& topColor, const glm
     return;
 }
 
-void AttractorGLApp::calculatePositionsToBeDrawnBoth()
+void AttractorGLApp::drawAttractors(const glm::mat4& projViewMat,
+                                    GLint from, GLsizei count)
 {
+    mFirstAttractor->draw(projViewMat, from, count);
+    /// Hidden segments of second attractor are dropped by its shader.
+    mSecondAttractor->draw(projViewMat, from, count);
+
+    /// Ensembles follow attractors' rotation.
+    for (auto* ensemble : { mFirstEnsemble.get(), mSecondEnsemble.get() })
+    {
+        if (!ensemble)
+            continue;
+        ensemble->rotateTo(mRotation);
+        ensemble->draw(projViewMat, from, count);
+    }
+}
+
+void AttractorGLApp::updateSyncDistance()
+{
+    if (!mDistancesEnabled)
+        return;
+
     const auto& firstPoints = mFirstAttractor->getTrajectoryVertices();
     const auto& secondPoints = mSecondAttractor->getTrajectoryVertices();
 
-    mPositionsToBeDrawnBoth.reserve(firstPoints.size());
+    /// Estimation needs whole trajectories.
+    if (mSyncLagEstimated)
+    {
+        if (mFirstAttractorStream || mSecondAttractorStream)
+            return;
+
+        mSyncLagEstimated = false;
+        mSyncDistance.setLag(SyncDistance::estimateLag(firstPoints, secondPoints,
+                                                       SYNC_MAX_LAG, SYNC_LAG_WINDOW));
+        resetSyncDistance();
+        std::cout << "Second trajectory lag " << mSyncDistance.getLag() << std::endl;
+    }
+
+    /// Points are only appended, so earlier distances stay on GPU.
+    /// Nearest approach takes GPU distances, statistics are kept.
+    mSyncDistance.update(firstPoints, secondPoints);
+    if (mNearestApproach || mSyncUploadedEnd == mSyncDistance.size())
+        return;
+
+    /// Distances are indexed from aligned point of second trajectory.
+    const auto& distances = mSyncDistance.getDistances();
+    const size_t offset = mSyncDistance.getSecondOffset();
+    mSecondAttractor->setDistances(distances.data() + mSyncUploadedEnd,
+                                   static_cast<GLsizei>(offset + mSyncUploadedEnd),
+                                   static_cast<GLsizei>(distances.size() - mSyncUploadedEnd));
+    mSyncUploadedEnd = distances.size();
+}
+
+void AttractorGLApp::resetSyncDistance()
+{
+    mSyncDistance.invalidate();
+    mSyncUploadedEnd = 0;
+    if (!mNearestApproach)
+        mSecondAttractor->clearDistances();
+}
+
+void AttractorGLApp::adjustDistanceThreshold(bool toIncrement)
+{
+    if (!mDistancesEnabled)
+        return;
+
+    GLfloat factor = 1.0f + DISTANCE_THRESHOLD_RATE * mFpsTimeDelta;
+    if (toIncrement)
+        mDistanceThreshold *= factor;
+    else
+        mDistanceThreshold /= factor;
+
+    /// Threshold is applied on GPU, distances are kept.
+    mSecondAttractor->setDistanceThreshold(mDistanceThreshold);
+}
+
+void AttractorGLApp::reportSyncDistance() const
+{
+    if (!mDistancesEnabled)
+        return;
+
+    std::cout << "Distance threshold " << mDistanceThreshold;
+    const size_t divergence = mSyncDistance.firstDivergence(mDistanceThreshold);
+    if (divergence < mSyncDistance.size())
+        std::cout << ", diverged at " << divergence;
+    std::cout << ", synchronized "
+              << 100.0 * mSyncDistance.synchronizedFraction(mDistanceThreshold) << "%"
+              << std::endl;
+}
+
+void AttractorGLApp::updateNearestApproach()
+{
+    if (mNearestPending)
+    {
+        if (mFirstAttractorStream || mSecondAttractorStream)
+            return;
+        mNearestPending = false;
+
+        mNearestCancelled = false;
+        mNearestStartTime = glfwGetTime();
+        mFirstNearestResult = computeNearestApproach(*mFirstAttractor, *mSecondAttractor);
+        mSecondNearestResult = computeNearestApproach(*mSecondAttractor, *mFirstAttractor);
+    }
+
+    if (mFirstNearestResult.valid())
+        collectNearestApproach(mFirstNearestResult, *mFirstAttractor, "first");
+    if (mSecondNearestResult.valid())
+        collectNearestApproach(mSecondNearestResult, *mSecondAttractor, "second");
+}
+
+std::future<NearestApproach::Field> AttractorGLApp::computeNearestApproach(
+        const AttractorModel& from, const AttractorModel& to)
+{
+    /// Copies share points, which are no longer appended to.
+    Trajectory fromPoints = from.getTrajectoryVertices();
+    Trajectory toPoints = to.getTrajectoryVertices();
+    return ThreadPool::instance().submit([this, fromPoints, toPoints]()
+    {
+        PointGrid grid(toPoints, NearestApproach::cellSize(toPoints));
+        return NearestApproach::compute(fromPoints, grid, mNearestCancelled);
+    });
+}
+
+void AttractorGLApp::collectNearestApproach(
+        std::future<NearestApproach::Field>& result, AttractorModel& model,
+        const std::string& name)
+{
+    if (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    /// Failed computation leaves model uncolored, viewer goes on.
+    NearestApproach::Field field;
+    try
+    {
+        field = result.get();
+    }
+    catch (std::exception& exc)
+    {
+        std::cerr << "Nearest approach of " << name << " attractor failed: "
+                  << exc.what() << std::endl;
+        return;
+    }
+
+    if (field.distances.empty())
+        return;
+
+    /// Near points keep color of attractor, far ones fade to white.
+    model.setDistances(field.distances.data(), 0,
+                       static_cast<GLsizei>(field.distances.size()));
+    model.setDistanceColors(glm::vec4(1.0f, 1.0f, 1.0f, model.getColor().a),
+                            field.scale);
+
+    std::cout << "Nearest approach of " << name << " attractor in "
+              << glfwGetTime() - mNearestStartTime << " s, "
+              << 100.0f * NearestApproach::SCALE_QUANTILE << "% within "
+              << field.scale << std::endl;
+}
+
+void AttractorGLApp::cancelNearestApproach()
+{
+    mNearestCancelled = true;
+    for (auto* result : { &mFirstNearestResult, &mSecondNearestResult })
+    {
+        if (result->valid())
+        {
+            result->wait();
+            *result = std::future<NearestApproach::Field>();
+        }
+    }
+}
+
+void AttractorGLApp::updateRecurrencePlot()
+{
+    if (mRecurrencePending)
+    {
+        if (mFirstAttractorStream || mSecondAttractorStream)
+            return;
+        mRecurrencePending = false;
+
+        /// Cross-recurrence has first attractor along x and second along y.
+        const AttractorModel& xModel = mRecurrenceSource == AttractorFilter::SECOND
+                                     ? *mSecondAttractor : *mFirstAttractor;
+        const AttractorModel& yModel = mRecurrenceSource == AttractorFilter::FIRST
+                                     ? *mFirstAttractor : *mSecondAttractor;
+        /// Settings are validated on command line.
+        mRecurrencePlot = std::make_unique<RecurrencePlot>(
+                xModel.getTrajectoryVertices(), yModel.getTrajectoryVertices(),
+                mRecurrenceSettings);
+        mRecurrenceModel = std::make_unique<RecurrenceModel>(
+                mRecurrencePlot->getWidth(), mRecurrencePlot->getHeight(),
+                mRecurrencePlot->getTopLevel());
+    }
+    if (!mRecurrencePlot)
+        return;
 
-    for (GLsizei idx = 0; idx < firstPoints.size(); ++idx)
+    /// Failed plot is dropped, viewer goes on.
+    std::string error = mRecurrencePlot->getError();
+    if (!error.empty())
     {
-        GLfloat distance = glm::distance(firstPoints[idx], secondPoints[idx]);
-        mPositionsToBeDrawnBoth.push_back(distance > DISTANCE_THRESHOLD);
+        std::cerr << error << std::endl;
+        mRecurrencePlot.reset();
+        return;
     }
 
+    RecurrencePlot::Tile tile;
+    while (mRecurrencePlot->poll(tile))
+        mRecurrenceModel->updateTile(tile);
+
+    /// Tiles of previous view not started yet are not wanted any more.
+    mRecurrencePlot->request(mRecurrenceModel->missingTiles());
+}
+
+void AttractorGLApp::adjustRecurrenceView()
+{
+    if (!mRecurrenceModel)
+        return;
+
+    const GLfloat zoom = std::pow(RECURRENCE_ZOOM_RATE, mFpsTimeDelta);
+    if (glfwGetKey(mWindow, GLFW_KEY_EQUAL) == GLFW_PRESS)
+        mRecurrenceModel->zoom(zoom);
+    if (glfwGetKey(mWindow, GLFW_KEY_MINUS) == GLFW_PRESS)
+        mRecurrenceModel->zoom(1.0f / zoom);
+
+    const GLfloat shift = RECURRENCE_PAN_RATE * mFpsTimeDelta;
+    if (glfwGetKey(mWindow, GLFW_KEY_LEFT) == GLFW_PRESS)
+        mRecurrenceModel->pan(glm::vec2(-shift, 0.0f));
+    if (glfwGetKey(mWindow, GLFW_KEY_RIGHT) == GLFW_PRESS)
+        mRecurrenceModel->pan(glm::vec2(shift, 0.0f));
+    if (glfwGetKey(mWindow, GLFW_KEY_DOWN) == GLFW_PRESS)
+        mRecurrenceModel->pan(glm::vec2(0.0f, -shift));
+    if (glfwGetKey(mWindow, GLFW_KEY_UP) == GLFW_PRESS)
+        mRecurrenceModel->pan(glm::vec2(0.0f, shift));
+}
+
+void AttractorGLApp::drawRecurrencePlot()
+{
+    if (!mRecurrenceModel)
+        return;
+
+    /// Window may have been resized, so size is taken every frame.
+    GLint width, height;
+    glfwGetFramebufferSize(mWindow, &width, &height);
+    const GLsizei side = std::min(width, height) / 2;
+    if (side <= 0)
+        return;
+
+    glViewport(width - side, 0, side, side);
+    glDisable(GL_DEPTH_TEST);
+    mRecurrenceModel->setViewportSize(side);
+    mRecurrenceModel->draw(glm::mat4(1.0f));
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, width, height);
+}
+
+void AttractorGLApp::reportUniformLookups()
+{
+    auto lookups = Shader::getLookupCounters();
+    Shader::resetLookupCounters();
+
+    /// Print only when per-frame numbers change.
+    if (lookups.driver != mFrameLookups.driver ||
+        lookups.cached != mFrameLookups.cached)
+    {
+        std::cout << "Uniform location lookups per frame: "
+                  << lookups.driver << " driver, "
+                  << lookups.cached << " cached" << std::endl;
+    }
+    mFrameLookups = lookups;
+
     return;
 }
 
@@ -510,6 +1440,92 @@ void AttractorGLApp::setSecondAttractorSection(std::string dir)
     mSecondAttractorSection = dir;
 }
 
+TrajectoryCache& AttractorGLApp::trajectoryCache()
+{
+    return mTrajectoryCache;
+}
+
+void AttractorGLApp::setBasinSystem(std::string system)
+{
+    mBasinSystem = system;
+}
+
+BasinMap::Settings& AttractorGLApp::basinSettings()
+{
+    return mBasinSettings;
+}
+
+LyapunovEstimator::Settings& AttractorGLApp::lyapunovSettings()
+{
+    return mLyapunovSettings;
+}
+
+void AttractorGLApp::setLyapunovSystem(std::string system)
+{
+    mLyapunovSystem = system;
+}
+
+void AttractorGLApp::addPoincareSurface(const PoincareSection::Surface& surface)
+{
+    mPoincareSurfaces.push_back(surface);
+}
+
+void AttractorGLApp::setPoincareDirection(PoincareSection::Direction direction)
+{
+    mPoincareDirection = direction;
+}
+
+void AttractorGLApp::setDistanceThreshold(GLfloat threshold)
+{
+    mDistanceThreshold = threshold;
+}
+
+void AttractorGLApp::setSyncLag(ptrdiff_t lag)
+{
+    mSyncDistance.setLag(lag);
+}
+
+void AttractorGLApp::setSyncLagEstimated(bool estimated)
+{
+    mSyncLagEstimated = estimated;
+}
+
+void AttractorGLApp::setNearestApproach(bool enabled)
+{
+    mNearestApproach = enabled;
+}
+
+void AttractorGLApp::setReportUniformLookups(bool enabled)
+{
+    mReportLookups = enabled;
+}
+
+void AttractorGLApp::setRecurrencePlot(AttractorFilter source)
+{
+    mRecurrence = true;
+    mRecurrenceSource = source;
+}
+
+RecurrencePlot::Settings& AttractorGLApp::recurrenceSettings()
+{
+    return mRecurrenceSettings;
+}
+
+Ensemble::Settings& AttractorGLApp::ensembleSettings()
+{
+    return mEnsembleSettings;
+}
+
+ResidencyBudget AttractorGLApp::residencyBudget() const
+{
+    return mResidencyBudget;
+}
+
+void AttractorGLApp::setResidencyBudget(const ResidencyBudget& budget)
+{
+    mResidencyBudget = budget;
+}
+
 void AttractorGLApp::setFrameBufferSizeCallback(void (* func)(GLFWwindow*, GLint, GLint))
 {
     glfwSetFramebufferSizeCallback(mWindow, func);
@@ -1,49 +1,112 @@
 #include <attractormodel.hpp>
 
-AttractorModel::AttractorModel(std::vector<glm::vec3> vertices,
-                               std::vector<glm::vec2> section)
+AttractorModel::AttractorModel(Trajectory vertices,
+                               std::vector<glm::vec2> section,
+                               TubeMode mode,
+                               const ResidencyBudget& budget)
     : GLModel()
+    , mSectionUploaded(false)
+    , mTubeMode(mode)
+    , mVao(0)
+    , mVbo(0)
+    , mEbo(0)
+    , mVboCapacity(0)
+    , mEboCapacity(0)
+    , mFramesVao(0)
+    , mPositionsVbo(0)
+    , mFramesVbo(0)
+    , mPositionsCapacity(0)
+    , mFramesCapacity(0)
+    , mDistancesVbo(0)
+    , mDistancesCapacity(0)
+    , mNDistances(0)
+    , mDistancesTexture(0)
+    , mDistanceThreshold(-1.0f)
+    , mFarColor(1.0f)
+    , mDistanceScale(0.0f)
 {
-    mTrajectoryVertices = vertices;
+    mTrajectoryVertices = std::move(vertices);
     mSectionVertices = section;
     mNSectionVertices = mSectionVertices.size();
 
+    mNSegments = std::max(0, static_cast<GLsizei>(mTrajectoryVertices.size()) - 1);
+    /// Closed strip around the section plus restart index.
+    mSegmentNIndices = 2*mNSectionVertices + 3;
+
     mRadius  = DFLT_RADIUS;
     mColor   = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
+    // Out-of-core frames are computed per drawn chunk
+    if ( budget.gpuBytes > 0 ) {
+        mTubeMode = TubeMode::EXTRUDED;
+        mChunkedTube = std::make_unique<ChunkedTube>(mTrajectoryVertices, budget);
+    }
+    else {
+        computeFrames();
+    }
     configure();
 }
 
 AttractorModel::~AttractorModel()
 {
     clearVertexData();
+
+    // Distances survive rebuilds of tube, so they go only with model
+    glDeleteTextures(1, &mDistancesTexture);
+    glDeleteBuffers(1, &mDistancesVbo);
 }
 
 void AttractorModel::configure()
 {
-
-    mVerticesBuffer = std::make_unique<glm::vec3[]>(mNSectionVertices);
-    mSegmentBuffer  = std::make_unique<glm::vec3[]>(2*mNSectionVertices+2);
-
-    mShader = std::make_unique<Shader>("shaders/attractor/vert.glsl",
-                                       "shaders/attractor/frag.glsl");
-
-    glm::vec3 startPoint = mTrajectoryVertices[0];
-    glm::vec3 normal = mTrajectoryVertices[1] - startPoint;
-
-    // Calculate perpendiculars for normal vector
-    glm::vec3 p1 = glm::cross(normal, glm::vec3(1.0f, 0.0f, 0.0f));
-    if ( glm::dot(p1, p1) < 0.3f )
-        p1 = glm::cross(normal, glm::vec3(0.0f, 1.0f, 0.0f));
-    p1 = glm::normalize(p1);
-    glm::vec3 p2 = glm::normalize(glm::cross(normal, p1));
-
-    // Calculate vertices of segment
-    glm::vec3 nextVertex;
-    for ( GLsizei i = 0; i < mNSectionVertices; i++ ) {
-        mVerticesBuffer[i] = startPoint +
-            mRadius * mSectionVertices[i].x * p1 +
-            mRadius * mSectionVertices[i].y * p2 ;
+    auto getLocations = [](const Shader& shader, ShaderLocations& locations)
+    {
+        locations.trans[0]    = shader.getUniformLocation("trans_0");
+        locations.trans[1]    = shader.getUniformLocation("trans_1");
+        locations.trans[2]    = shader.getUniformLocation("trans_2");
+        locations.trans[3]    = shader.getUniformLocation("trans_3");
+        locations.color       = shader.getUniformLocation("color");
+        locations.radius      = shader.getUniformLocation("radius");
+        locations.sectionSize = shader.getUniformLocation("section_size");
+        locations.section     = shader.getUniformLocation("section");
+        locations.threshold   = shader.getUniformLocation("threshold");
+        locations.distances   = shader.getUniformLocation("distances");
+        locations.farColor    = shader.getUniformLocation("far_color");
+        locations.distanceScale = shader.getUniformLocation("distance_scale");
+    };
+
+    if ( mTubeMode == TubeMode::MESH ) {
+        if ( !mMeshShader ) {
+            mMeshShader = std::make_unique<Shader>(
+                "shaders/attractor_mesh/vert.glsl",
+                "shaders/attractor_mesh/frag.glsl");
+            getLocations(*mMeshShader, mMeshLocations);
+        }
+        if ( !mVao )
+            computeMesh();
+    }
+    else {
+        if ( mNSectionVertices > MAX_EXTRUDED_SECTION_VERTICES )
+            throw std::runtime_error("Section has too many vertices: " +
+                                     std::to_string(mNSectionVertices));
+
+        if ( !mExtrudedShader ) {
+            mExtrudedShader = std::make_unique<Shader>(
+                "shaders/attractor_extruded/vert.glsl",
+                "shaders/attractor_extruded/frag.glsl");
+            getLocations(*mExtrudedShader, mExtrudedLocations);
+        }
+        if ( !mFramesVao && mChunkedTube ) {
+            // Buffers are bound per chunk at draw time
+            glGenVertexArrays(1, &mFramesVao);
+            glBindVertexArray(mFramesVao);
+            for ( GLuint i = 0; i < 6; i++ ) {
+                glEnableVertexAttribArray(i);
+                glVertexAttribDivisor(i, 1);
+            }
+            glBindVertexArray(0);
+        }
+        if ( !mFramesVao )
+            uploadFrames();
     }
 
     return;
@@ -51,7 +114,7 @@ void AttractorModel::configure()
 
 void AttractorModel::draw(const glm::mat4& viewProjectionMatrix)
 {
-    draw(viewProjectionMatrix, 0, 2);
+    draw(viewProjectionMatrix, 0, mNSegments);
     return;
 }
 
@@ -59,32 +122,108 @@ void AttractorModel::draw(
         const glm::mat4& viewProjectionMatrix,
         GLint from, GLsizei count)
 {
-    mShader->use();
-    setMvpMatrix(std::move(viewProjectionMatrix * getModelMatrix()));
-    mShader->setVec4("color", mColor);
+    from  = std::max(0, from);
+    count = std::min(count, mNSegments - from);
+    if ( count <= 0 )
+        return;
 
-    for ( GLint i = 0; i < count; i++ )
-        drawSegment(from + i);
+    mVisibleRanges.firsts.assign(1, from);
+    mVisibleRanges.counts.assign(1, count);
+
+    setDrawState(viewProjectionMatrix);
+    drawVisibleRanges();
 
     return;
 }
 
 void AttractorModel::clearVertexData()
 {
-    for ( auto vao : mSegmentsVaos )
-        glDeleteVertexArrays(1, &vao);
-    mSegmentsVaos.clear();
-
-    for ( auto vbo : mSegmentsVbos )
-        glDeleteBuffers(1, &vbo);
-    mSegmentsVbos.clear();
+    glDeleteVertexArrays(1, &mVao);
+    glDeleteBuffers(1, &mVbo);
+    glDeleteBuffers(1, &mEbo);
+    mVao = mVbo = mEbo = 0;
+    mVboCapacity = mEboCapacity = 0;
+
+    if ( mChunkedTube )
+        mChunkedTube->clear();
+
+    glDeleteVertexArrays(1, &mFramesVao);
+    glDeleteBuffers(1, &mPositionsVbo);
+    glDeleteBuffers(1, &mFramesVbo);
+    mFramesVao = mPositionsVbo = mFramesVbo = 0;
+    mPositionsCapacity = mFramesCapacity = 0;
 }
 
-const std::vector<glm::vec3>& AttractorModel::getTrajectoryVertices() const
+const Trajectory& AttractorModel::getTrajectoryVertices() const
 {
     return mTrajectoryVertices;
 }
 
+GLsizei AttractorModel::getNSegments() const
+{
+    return mNSegments;
+}
+
+void AttractorModel::appendVertices(const Trajectory& points)
+{
+    if ( points.empty() )
+        return;
+
+    const GLsizei oldNPoints   = mTrajectoryVertices.size();
+    const GLsizei oldNSegments = mNSegments;
+
+    mTrajectoryVertices.append(points);
+    mNSegments = std::max(0, static_cast<GLsizei>(mTrajectoryVertices.size()) - 1);
+
+    // New points have no distance yet
+    if ( mDistancesVbo )
+        reserveDistances(mTrajectoryVertices.size());
+
+    // Out-of-core chunks are built when drawn
+    if ( mChunkedTube ) {
+        mChunkedTube->invalidateFrom(std::max(0, oldNPoints - 1));
+        return;
+    }
+
+    // Tangent of former last point now sees next point, so its frame changes
+    const GLsizei fromPoint = oldNPoints >= 2 ? oldNPoints - 1 : 0;
+    computeFrames(fromPoint);
+
+    if ( mTubeMode == TubeMode::MESH && mVao )
+        computeMesh(fromPoint, oldNSegments);
+    else if ( mTubeMode == TubeMode::EXTRUDED && mFramesVao )
+        uploadFrames(fromPoint, oldNPoints);
+    else
+        configure();
+
+    return;
+}
+
+void AttractorModel::setTrajectoryVertices(Trajectory points)
+{
+    mTrajectoryVertices = std::move(points);
+    mNSegments = std::max(0, static_cast<GLsizei>(mTrajectoryVertices.size()) - 1);
+
+    if ( mDistancesVbo )
+        reserveDistances(mTrajectoryVertices.size());
+
+    if ( mChunkedTube ) {
+        mChunkedTube->invalidateFrom(0);
+        return;
+    }
+
+    computeFrames();
+
+    if ( mTubeMode == TubeMode::MESH && mVao )
+        computeMesh();
+    else if ( mTubeMode == TubeMode::EXTRUDED && mFramesVao )
+        uploadFrames();
+    else
+        configure();
+
+    return;
+}
+
 GLfloat AttractorModel::getNRadius() const
 {
     return mRadius;
@@ -94,7 +233,27 @@ void AttractorModel::setRadius(GLfloat radius)
 {
     mRadius = std::max(0.0f, radius);
 
-    clearVertexData();
+    // Extruded tube only needs new uniform value
+    if ( mTubeMode == TubeMode::MESH ) {
+        clearVertexData();
+        configure();
+    }
+}
+
+const std::vector<glm::vec2>& AttractorModel::getSectionVertices() const
+{
+    return mSectionVertices;
+}
+
+void AttractorModel::setSectionVertices(std::vector<glm::vec2> section)
+{
+    mSectionVertices = std::move(section);
+    mNSectionVertices = mSectionVertices.size();
+    mSegmentNIndices = 2*mNSectionVertices + 3;
+    mSectionUploaded = false;
+
+    if ( mTubeMode == TubeMode::MESH )
+        clearVertexData();
     configure();
 }
 
@@ -108,69 +267,495 @@ void AttractorModel::setColor(const glm::vec4& color)
     mColor = color;
 }
 
+void AttractorModel::setDistances(const GLfloat* distances, GLsizei first, GLsizei count)
+{
+    reserveDistances(std::max(first + count,
+                              static_cast<GLsizei>(mTrajectoryVertices.size())));
+    if ( count <= 0 )
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, mDistancesVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(GLfloat),
+                    count * sizeof(GLfloat), distances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return;
+}
+
+void AttractorModel::clearDistances()
+{
+    if ( !mDistancesVbo )
+        return;
+
+    std::vector<GLfloat> zeros(mNDistances, 0.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, mDistancesVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, zeros.size() * sizeof(GLfloat), zeros.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return;
+}
+
+GLfloat AttractorModel::getDistanceThreshold() const
+{
+    return mDistanceThreshold;
+}
+
+void AttractorModel::setDistanceThreshold(GLfloat threshold)
+{
+    mDistanceThreshold = threshold;
+}
+
+void AttractorModel::setDistanceColors(const glm::vec4& farColor, GLfloat scale)
+{
+    mFarColor = farColor;
+    mDistanceScale = scale;
+}
+
+TubeMode AttractorModel::getTubeMode() const
+{
+    return mTubeMode;
+}
+
+void AttractorModel::setTubeMode(TubeMode mode)
+{
+    if ( mode == mTubeMode || mChunkedTube )
+        return;
+
+    mTubeMode = mode;
+    mSectionUploaded = false;
+
+    clearVertexData();
+    configure();
+}
+
+bool AttractorModel::isOutOfCore() const
+{
+    return mChunkedTube != nullptr;
+}
+
 void AttractorModel::setMvpMatrix(const glm::mat4& mvp)
 {
+    const Shader& shader = mTubeMode == TubeMode::MESH ? *mMeshShader
+                                                       : *mExtrudedShader;
+    const ShaderLocations& locations = mTubeMode == TubeMode::MESH
+                                     ? mMeshLocations : mExtrudedLocations;
+
     // Dirty trick to avoid hardware bug
-    mShader->setVec4("trans_0", mvp[0][0], mvp[0][1], mvp[0][2], mvp[0][3]);
-    mShader->setVec4("trans_1", mvp[1][0], mvp[1][1], mvp[1][2], mvp[1][3]);
-    mShader->setVec4("trans_2", mvp[2][0], mvp[2][1], mvp[2][2], mvp[2][3]);
-    mShader->setVec4("trans_3", mvp[3][0], mvp[3][1], mvp[3][2], mvp[3][3]);
+    for ( GLint i = 0; i < 4; i++ )
+        shader.setVec4(locations.trans[i],
+                       mvp[i][0], mvp[i][1], mvp[i][2], mvp[i][3]);
+
+    return;
+}
+
+void AttractorModel::setDrawState(const glm::mat4& viewProjectionMatrix)
+{
+    if ( mTubeMode == TubeMode::MESH ) {
+        mMeshShader->use();
+        setMvpMatrix(std::move(viewProjectionMatrix * getModelMatrix()));
+        mMeshShader->setVec4(mMeshLocations.color, mColor);
+        mMeshShader->setFloat(mMeshLocations.threshold, mDistanceThreshold);
+        mMeshShader->setVec4(mMeshLocations.farColor, mFarColor);
+        mMeshShader->setFloat(mMeshLocations.distanceScale, mDistanceScale);
+        mMeshShader->setInt(mMeshLocations.sectionSize, mNSectionVertices);
+        mMeshShader->setInt(mMeshLocations.distances, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, mDistancesTexture);
+
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(RESTART_INDEX);
+    }
+    else {
+        mExtrudedShader->use();
+        mDrawMvp = viewProjectionMatrix * getModelMatrix();
+        setMvpMatrix(mDrawMvp);
+        mExtrudedShader->setVec4(mExtrudedLocations.color, mColor);
+        mExtrudedShader->setFloat(mExtrudedLocations.radius, mRadius);
+        mExtrudedShader->setFloat(mExtrudedLocations.threshold, mDistanceThreshold);
+        mExtrudedShader->setVec4(mExtrudedLocations.farColor, mFarColor);
+        mExtrudedShader->setFloat(mExtrudedLocations.distanceScale, mDistanceScale);
+
+        // Program keeps uniform values, so section is sent on change only
+        if ( !mSectionUploaded ) {
+            mExtrudedShader->setInt(mExtrudedLocations.sectionSize,
+                                    mNSectionVertices);
+            mExtrudedShader->setVec2Array(mExtrudedLocations.section,
+                                          mSectionVertices.data(),
+                                          mNSectionVertices);
+            mSectionUploaded = true;
+        }
+    }
 
     return;
 }
 
-void AttractorModel::drawSegment(GLint segmentNo)
+void AttractorModel::drawVisibleRanges()
 {
-    if ( segmentNo >= mSegmentsVaos.size() ) {
-        for ( int i = mSegmentsVaos.size(); i <= segmentNo; i++ ) {
-            GLuint vao, vbo;
-            computeSegment(i, vao, vbo);
-            mSegmentsVaos.push_back(vao);
-            mSegmentsVbos.push_back(vbo);
+    const auto& firsts = mVisibleRanges.firsts;
+    const auto& counts = mVisibleRanges.counts;
+
+    if ( mTubeMode == TubeMode::MESH ) {
+        mMultiDrawCounts.clear();
+        mMultiDrawOffsets.clear();
+        for ( size_t i = 0; i < firsts.size(); i++ ) {
+            mMultiDrawCounts.push_back(counts[i] * mSegmentNIndices);
+            mMultiDrawOffsets.push_back(reinterpret_cast<const GLvoid*>(
+                firsts[i] * mSegmentNIndices * sizeof(GLuint)));
         }
+
+        glBindVertexArray(mVao);
+        if ( firsts.size() == 1 )
+            glDrawElements(GL_TRIANGLE_STRIP, mMultiDrawCounts[0],
+                           GL_UNSIGNED_INT, mMultiDrawOffsets[0]);
+        else
+            glMultiDrawElements(GL_TRIANGLE_STRIP, mMultiDrawCounts.data(),
+                                GL_UNSIGNED_INT, mMultiDrawOffsets.data(),
+                                mMultiDrawCounts.size());
+        glBindVertexArray(0);
+    }
+    else if ( mChunkedTube ) {
+        drawChunkedRanges();
     }
+    else {
+        // No base instance in GL 3.3, so attributes are re-pointed instead
+        glBindVertexArray(mFramesVao);
+        for ( size_t i = 0; i < firsts.size(); i++ ) {
+            bindExtrudedSegments(mPositionsVbo, mFramesVbo, firsts[i], firsts[i]);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0,
+                                  2*mNSectionVertices + 2, counts[i]);
+        }
+        glBindVertexArray(0);
+    }
+
+    return;
+}
 
-    glBindVertexArray(mSegmentsVaos[segmentNo]);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 2*mNSectionVertices+2);
+void AttractorModel::drawChunkedRanges()
+{
+    // Ranges are split at chunk borders, chunks out of view are skipped
+    mDrawnChunks.clear();
+    mChunkRanges.firsts.clear();
+    mChunkRanges.counts.clear();
+    for ( size_t i = 0; i < mVisibleRanges.firsts.size(); i++ ) {
+        const GLint end = mVisibleRanges.firsts[i] + mVisibleRanges.counts[i];
+        for ( GLint first = mVisibleRanges.firsts[i]; first < end; ) {
+            GLsizei chunk = ChunkedTube::chunkOf(first);
+            GLint   last  = std::min(end, (chunk + 1) * ChunkedTube::CHUNK_SEGMENTS);
+            if ( mChunkedTube->isVisible(chunk, mDrawMvp, mRadius) ) {
+                if ( mDrawnChunks.empty() || mDrawnChunks.back() != chunk )
+                    mDrawnChunks.push_back(chunk);
+                mChunkRanges.firsts.push_back(first);
+                mChunkRanges.counts.push_back(last - first);
+            }
+            first = last;
+        }
+    }
+    if ( mDrawnChunks.empty() )
+        return;
+
+    mChunkedTube->acquire(mDrawnChunks, mResidentChunks);
+
+    glBindVertexArray(mFramesVao);
+    size_t resident = 0;
+    for ( size_t i = 0; i < mChunkRanges.firsts.size(); i++ ) {
+        GLint first = mChunkRanges.firsts[i];
+        while ( mDrawnChunks[resident] != ChunkedTube::chunkOf(first) )
+            resident++;
+
+        const ChunkedTube::Chunk& chunk = *mResidentChunks[resident];
+        bindExtrudedSegments(chunk.positionsVbo, chunk.framesVbo,
+                             first - chunk.firstSegment, first);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0,
+                              2*mNSectionVertices + 2, mChunkRanges.counts[i]);
+    }
     glBindVertexArray(0);
 
+    mChunkedTube->evict();
+
     return;
 }
 
-void AttractorModel::computeSegment(GLint segmentNo, GLuint& vao, GLuint& vbo)
+void AttractorModel::bindExtrudedSegments(GLuint positionsVbo, GLuint framesVbo,
+                                          GLint from, GLint distancesFrom)
 {
+    // Attributes 0-2 hold bottom point and frame of segment, 3-5 top ones
+    for ( GLuint i = 0; i < 6; i++ ) {
+        GLint point = from + i / 3;
+        size_t offset;
+        if ( i % 3 == 0 ) {
+            glBindBuffer(GL_ARRAY_BUFFER, positionsVbo);
+            offset = point * sizeof(glm::vec3);
+        }
+        else {
+            glBindBuffer(GL_ARRAY_BUFFER, framesVbo);
+            offset = point * sizeof(TubeFrame) + (i % 3 - 1) * sizeof(glm::vec3);
+        }
+        glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE,
+                              i % 3 == 0 ? sizeof(glm::vec3) : sizeof(TubeFrame),
+                              reinterpret_cast<GLvoid*>(offset));
+    }
 
-    glm::vec3 topPoint = mTrajectoryVertices[segmentNo+1];
-    glm::vec3 normal = topPoint - mTrajectoryVertices[segmentNo];
+    // Attribute 6 holds distance of bottom point, zero without distances
+    if ( mDistancesVbo ) {
+        glBindBuffer(GL_ARRAY_BUFFER, mDistancesVbo);
+        glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat),
+                              reinterpret_cast<GLvoid*>(distancesFrom * sizeof(GLfloat)));
+        glVertexAttribDivisor(6, 1);
+        glEnableVertexAttribArray(6);
+    }
+    else {
+        glDisableVertexAttribArray(6);
+        glVertexAttrib1f(6, 0.0f);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return;
+}
 
-    // Calculate perpendiculars for normal vector
-    glm::vec3 p1 = glm::cross(normal, glm::vec3(1.0f, 0.0f, 0.0f));
-    if ( glm::dot(p1, p1) < 0.3f )
-        p1 = glm::cross(normal, glm::vec3(0.0f, 1.0f, 0.0f));
-    p1 = glm::normalize(p1);
-    glm::vec3 p2 = glm::normalize(glm::cross(normal, p1));
+void AttractorModel::computeFrames(GLsizei fromPoint)
+{
+    mFrames.resize(mTrajectoryVertices.size());
+    if ( mNSegments == 0 )
+        return;
+
+    ThreadPool& pool = ThreadPool::instance();
+    const auto& points = mTrajectoryVertices;
+    const GLsizei nPoints = points.size();
+
+    // Frames are transported from the last kept one
+    const GLsizei base = std::max(fromPoint - 1, 0);
+
+    // Repeated points carry last valid tangent forward: chunks carry from
+    // zero, then their leading zeros take last valid one of chunks before
+    const GLsizei nTangents = nPoints - base;
+    const GLsizei nTangentChunks = (nTangents + MESH_GRAIN - 1) / MESH_GRAIN;
+
+    std::vector<glm::vec3> tangents(nTangents);
+    std::vector<glm::vec3> lastTangents(nTangentChunks);
+    pool.parallelFor(0, nTangentChunks, 1, [&](size_t chunk, size_t) {
+        GLsizei end = base + std::min<GLsizei>((chunk + 1) * MESH_GRAIN, nTangents);
+        glm::vec3 t(0.0f);
+        for ( GLsizei i = base + chunk * MESH_GRAIN; i < end; i++ ) {
+            t = TubeGeometry::tangent(points.data(), nPoints, i, t);
+            tangents[i - base] = t;
+        }
+        lastTangents[chunk] = t;
+    });
+
+    // Kept frame before base holds tangent carried into it
+    glm::vec3 carried = TubeGeometry::DEFAULT_TANGENT;
+    if ( base > 0 )
+        carried = glm::normalize(glm::cross(mFrames[base-1].p1, mFrames[base-1].p2));
+    std::vector<glm::vec3> chunkCarried(nTangentChunks);
+    for ( GLsizei chunk = 0; chunk < nTangentChunks; chunk++ ) {
+        chunkCarried[chunk] = carried;
+        if ( glm::dot(lastTangents[chunk], lastTangents[chunk]) > 0.0f )
+            carried = lastTangents[chunk];
+    }
 
-    // Calculate vertices of segment
-    glm::vec3 nextVertex;
-    for ( GLsizei i = 0; i < mNSectionVertices; i++ ) {
-        nextVertex = topPoint +
-            mRadius * mSectionVertices[i].x * p1 +
-            mRadius * mSectionVertices[i].y * p2 ;
-        mSegmentBuffer[2*i] = mVerticesBuffer[i];
-        mSegmentBuffer[2*i+1] = mVerticesBuffer[i] = nextVertex;
+    pool.parallelFor(0, nTangentChunks, 1, [&](size_t chunk, size_t) {
+        GLsizei end = base + std::min<GLsizei>((chunk + 1) * MESH_GRAIN, nTangents);
+        for ( GLsizei i = base + chunk * MESH_GRAIN;
+              i < end && glm::dot(tangents[i-base], tangents[i-base]) == 0.0f; i++ )
+            tangents[i - base] = chunkCarried[chunk];
+    });
+
+    auto transport = [&](GLsizei i, const glm::vec3& x)
+    {
+        return TubeGeometry::transport(points[i], points[i+1],
+                                       tangents[i-base], tangents[i+1-base], x);
+    };
+
+    // Calculate perpendiculars for first tangent
+    if ( fromPoint == 0 ) {
+        glm::vec3 r = TubeGeometry::initialNormal(tangents[0]);
+        mFrames[0] = { r, glm::normalize(glm::cross(tangents[0], r)) };
     }
-    mSegmentBuffer[2*mNSectionVertices]   = mSegmentBuffer[0];
-    mSegmentBuffer[2*mNSectionVertices+1] = mSegmentBuffer[1];
 
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, (2*mNSectionVertices + 2) * sizeof(glm::vec3),
-                 mSegmentBuffer.get(), GL_STATIC_DRAW);
+    // Transport is linear in x, so frames are a prefix product of
+    // per-chunk transforms: build transforms, scan them, then propagate
+    const GLsizei nSteps  = nPoints - 1 - base;
+    const GLsizei nChunks = (nSteps + MESH_GRAIN - 1) / MESH_GRAIN;
+
+    std::vector<glm::mat3> transforms(nChunks, glm::mat3(1.0f));
+    pool.parallelFor(0, nChunks, 1, [&](size_t chunk, size_t) {
+        GLsizei end = base + std::min<GLsizei>((chunk + 1) * MESH_GRAIN, nSteps);
+        for ( GLsizei i = base + chunk * MESH_GRAIN; i < end; i++ )
+            for ( GLint axis = 0; axis < 3; axis++ )
+                transforms[chunk][axis] = transport(i, transforms[chunk][axis]);
+    });
+
+    std::vector<glm::vec3> chunkStarts(nChunks);
+    chunkStarts[0] = mFrames[base].p1;
+    for ( GLsizei chunk = 1; chunk < nChunks; chunk++ )
+        chunkStarts[chunk] = glm::normalize(transforms[chunk-1] *
+                                            chunkStarts[chunk-1]);
+
+    pool.parallelFor(0, nChunks, 1, [&](size_t chunk, size_t) {
+        GLsizei end = base + std::min<GLsizei>((chunk + 1) * MESH_GRAIN, nSteps);
+        glm::vec3 x = chunkStarts[chunk];
+        for ( GLsizei i = base + chunk * MESH_GRAIN; i < end; i++ ) {
+            x = transport(i, x);
+            mFrames[i+1] = { x, glm::normalize(glm::cross(tangents[i+1-base], x)) };
+        }
+    });
+
+    return;
+}
+
+void AttractorModel::computeMesh(GLsizei fromPoint, GLsizei fromSegment)
+{
+    if ( mNSegments == 0 )
+        return;
+
+    ThreadPool& pool = ThreadPool::instance();
+    const GLsizei nPoints = mFrames.size();
+
+    // Consecutive segments share the ring of their common point
+    std::vector<glm::vec3> vertices((nPoints - fromPoint) * mNSectionVertices);
+    std::vector<GLuint> indices((mNSegments - fromSegment) * mSegmentNIndices);
+
+    pool.parallelFor(fromPoint, nPoints, MESH_GRAIN,
+                     [&](size_t begin, size_t end) {
+        TubeGeometry::generateRings(&mTrajectoryVertices[begin],
+                                    &mFrames[begin], end - begin,
+                                    mSectionVertices.data(), mNSectionVertices,
+                                    mRadius,
+                                    &vertices[(begin - fromPoint) * mNSectionVertices]);
+    });
+
+    pool.parallelFor(fromSegment, mNSegments, MESH_GRAIN,
+                     [&](size_t begin, size_t end) {
+        for ( size_t s = begin; s < end; s++ ) {
+            GLuint* index  = &indices[(s - fromSegment) * mSegmentNIndices];
+            GLuint  bottom = s * mNSectionVertices;
+            GLuint  top    = bottom + mNSectionVertices;
+
+            for ( GLsizei i = 0; i < mNSectionVertices; i++ ) {
+                index[2*i]   = bottom + i;
+                index[2*i+1] = top + i;
+            }
+            index[2*mNSectionVertices]   = bottom;
+            index[2*mNSectionVertices+1] = top;
+            index[2*mNSectionVertices+2] = RESTART_INDEX;
+        }
+    });
+
+    if ( !mVao )
+        glGenVertexArrays(1, &mVao);
+    glBindVertexArray(mVao);
+
+    const GLsizeiptr ringSize = mNSectionVertices * sizeof(glm::vec3);
+    reserveBuffer(mVbo, mVboCapacity, fromPoint * ringSize, nPoints * ringSize);
+    glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, fromPoint * ringSize,
+                    vertices.size() * sizeof(glm::vec3), vertices.data());
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
                           reinterpret_cast<GLvoid*>(0));
     glEnableVertexAttribArray(0);
+
+    const GLsizeiptr segmentSize = mSegmentNIndices * sizeof(GLuint);
+    reserveBuffer(mEbo, mEboCapacity, fromSegment * segmentSize,
+                  mNSegments * segmentSize);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, fromSegment * segmentSize,
+                    indices.size() * sizeof(GLuint), indices.data());
+
+    glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return;
+}
+
+void AttractorModel::uploadFrames(GLsizei fromFrame, GLsizei fromPosition)
+{
+    if ( mNSegments == 0 )
+        return;
+
+    const GLsizei nPoints = mTrajectoryVertices.size();
+
+    if ( !mFramesVao ) {
+        glGenVertexArrays(1, &mFramesVao);
+        glBindVertexArray(mFramesVao);
+        for ( GLuint i = 0; i < 6; i++ ) {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+    }
+    glBindVertexArray(mFramesVao);
+
+    // Points go to GPU as they are, e.g. straight from mapped file
+    reserveBuffer(mPositionsVbo, mPositionsCapacity,
+                  fromPosition * sizeof(glm::vec3), nPoints * sizeof(glm::vec3));
+    glBindBuffer(GL_ARRAY_BUFFER, mPositionsVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, fromPosition * sizeof(glm::vec3),
+                    (nPoints - fromPosition) * sizeof(glm::vec3),
+                    &mTrajectoryVertices[fromPosition]);
+
+    reserveBuffer(mFramesVbo, mFramesCapacity,
+                  fromFrame * sizeof(TubeFrame), nPoints * sizeof(TubeFrame));
+    glBindBuffer(GL_ARRAY_BUFFER, mFramesVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, fromFrame * sizeof(TubeFrame),
+                    (nPoints - fromFrame) * sizeof(TubeFrame),
+                    &mFrames[fromFrame]);
+    bindExtrudedSegments(mPositionsVbo, mFramesVbo, 0, 0);
+
     glBindVertexArray(0);
+
+    return;
+}
+
+void AttractorModel::reserveDistances(GLsizei nPoints)
+{
+    if ( mDistancesVbo && nPoints <= mNDistances )
+        return;
+
+    const GLsizeiptr used = mNDistances * sizeof(GLfloat);
+    reserveBuffer(mDistancesVbo, mDistancesCapacity, used,
+                  std::max<GLsizeiptr>(nPoints * sizeof(GLfloat), sizeof(GLfloat)));
+
+    // Zero distance hides point under any threshold, as unknown one should be
+    std::vector<GLfloat> zeros(std::max(0, nPoints - mNDistances), 0.0f);
+    glBindBuffer(GL_ARRAY_BUFFER, mDistancesVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, used, zeros.size() * sizeof(GLfloat), zeros.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mNDistances = std::max(mNDistances, nPoints);
+
+    // Buffer may be a new one, so mesh texture is pointed at it again
+    if ( !mDistancesTexture )
+        glGenTextures(1, &mDistancesTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, mDistancesTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, mDistancesVbo);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    return;
+}
+
+void AttractorModel::reserveBuffer(GLuint& buffer, GLsizeiptr& capacity,
+                                   GLsizeiptr used, GLsizeiptr size)
+{
+    if ( buffer && size <= capacity )
+        return;
+
+    // First allocation is exact, growth is geometric for streamed data
+    GLsizeiptr newCapacity = buffer ? std::max(size, 2 * capacity) : size;
+    GLuint newBuffer;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, nullptr,
+                 buffer ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+
+    if ( buffer && used > 0 ) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            0, 0, used);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+
+    buffer   = newBuffer;
+    capacity = newCapacity;
+
+    return;
 }
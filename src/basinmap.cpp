@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <basinmap.hpp>
+#include <threadpool.hpp>
+
+BasinMap::BasinMap(const OdeIntegrator::Settings& integration,
+                   const Settings& settings,
+                   Trajectory first, Trajectory second)
+    : mIntegration(integration)
+    , mSettings(settings)
+{
+    if (mSettings.resolution <= 0 || mSettings.tileSize <= 0 ||
+        mSettings.samples == 0 || !(mSettings.distance > 0.0f))
+        throw std::runtime_error("Basin resolution, tile size, samples "
+                                 "and distance must be positive");
+
+    mJob.start([this, first, second]() { compute(first, second); });
+}
+
+BasinMap::~BasinMap()
+{
+    cancel();
+}
+
+bool BasinMap::poll(Tile& tile)
+{
+    return mJob.poll(tile);
+}
+
+bool BasinMap::isFinished() const
+{
+    return mJob.isFinished();
+}
+
+std::string BasinMap::getError() const
+{
+    return mJob.getError();
+}
+
+void BasinMap::cancel()
+{
+    mJob.cancel();
+}
+
+const BasinMap::Settings& BasinMap::getSettings() const
+{
+    return mSettings;
+}
+
+glm::dvec3 BasinMap::initialCondition(int x, int y) const
+{
+    const double step = 2.0 * mSettings.halfSize / mSettings.resolution;
+    return glm::dvec3(mSettings.center.x - mSettings.halfSize + (x + 0.5) * step,
+                      mSettings.center.y - mSettings.halfSize + (y + 0.5) * step,
+                      mSettings.center.z);
+}
+
+void BasinMap::compute(Trajectory first, Trajectory second)
+{
+    /// Cells as large as query distance, so queries visit 27 cells.
+    PointGrid firstGrid(std::move(first), mSettings.distance);
+    PointGrid secondGrid(std::move(second), mSettings.distance);
+
+    /// Tiles near slice center first, they are the most interesting.
+    const int resolution = mSettings.resolution;
+    const int tileSize = mSettings.tileSize;
+    std::vector<Tile> tiles;
+    for (int y = 0; y < resolution; y += tileSize)
+    {
+        for (int x = 0; x < resolution; x += tileSize)
+        {
+            Tile tile;
+            tile.x = x;
+            tile.y = y;
+            tile.width = std::min(tileSize, resolution - x);
+            tile.height = std::min(tileSize, resolution - y);
+            tiles.push_back(std::move(tile));
+        }
+    }
+    auto centerDistance = [resolution](const Tile& tile)
+    {
+        int dx = 2 * tile.x + tile.width - resolution;
+        int dy = 2 * tile.y + tile.height - resolution;
+        return dx * dx + dy * dy;
+    };
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [&centerDistance](const Tile& a, const Tile& b)
+    {
+        return centerDistance(a) < centerDistance(b);
+    });
+
+    ThreadPool::instance().parallelFor(0, tiles.size(), 1,
+                                       [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (mJob.isCancelled())
+                return;
+
+            computeTile(firstGrid, secondGrid, tiles[i]);
+            mJob.push(std::move(tiles[i]));
+        }
+    });
+}
+
+void BasinMap::computeTile(const PointGrid& first, const PointGrid& second,
+                           Tile& tile) const
+{
+    const OdeSystem& system = mIntegration.system;
+    const size_t count = static_cast<size_t>(tile.width) * tile.height;
+    const size_t samples = mSettings.samples;
+
+    std::vector<double> x(count), y(count), z(count);
+    for (int j = 0; j < tile.height; ++j)
+    {
+        for (int i = 0; i < tile.width; ++i)
+        {
+            glm::dvec3 initial = initialCondition(tile.x + i, tile.y + j);
+            size_t lane = static_cast<size_t>(j) * tile.width + i;
+            x[lane] = initial.x;
+            y[lane] = initial.y;
+            z[lane] = initial.z;
+        }
+    }
+
+    /// Only samples after transient are kept, in drawn coordinates.
+    std::vector<glm::vec3> points(count * samples);
+    system.rk4Lanes(x.data(), y.data(), z.data(), count,
+                    system.parameters.data(), system.dt,
+                    mSettings.transient, mSettings.transient + samples,
+                    system.scale, points.data(), samples);
+
+    tile.labels.resize(count);
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        if (!std::isfinite(x[lane] + y[lane] + z[lane]))
+        {
+            tile.labels[lane] = DIVERGED;
+            continue;
+        }
+
+        size_t nearFirst = 0;
+        size_t nearSecond = 0;
+        for (size_t k = 0; k < samples; ++k)
+        {
+            const glm::vec3& point = points[lane * samples + k];
+            nearFirst += first.nearest(point, mSettings.distance) != PointGrid::NONE;
+            nearSecond += second.nearest(point, mSettings.distance) != PointGrid::NONE;
+        }
+
+        /// Overlapping attractors decide nothing.
+        if (nearFirst == nearSecond)
+            tile.labels[lane] = UNKNOWN;
+        else
+            tile.labels[lane] = nearFirst > nearSecond ? FIRST : SECOND;
+    }
+}
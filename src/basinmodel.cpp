@@ -0,0 +1,120 @@
+#include <vector>
+
+#include <basinmodel.hpp>
+
+BasinModel::BasinModel(GLsizei resolution, const glm::vec3& origin,
+                       const glm::vec3& axisU, const glm::vec3& axisV)
+    : GLModel()
+    , mResolution(resolution)
+    , mOrigin(origin)
+    , mAxisU(axisU)
+    , mAxisV(axisV)
+    , mFirstColor(1.0f, 0.0f, 0.0f, 0.4f)
+    , mSecondColor(0.0f, 0.0f, 1.0f, 0.4f)
+    , mDivergedColor(0.0f, 0.0f, 0.0f, 0.4f)
+    , mVao(0)
+    , mTexture(0)
+{
+    configure();
+}
+
+BasinModel::~BasinModel()
+{
+    clearVertexData();
+}
+
+void BasinModel::configure()
+{
+    if ( !mShader ) {
+        mShader = std::make_unique<Shader>("shaders/basin/vert.glsl",
+                                           "shaders/basin/frag.glsl");
+        mLocations.trans[0]      = mShader->getUniformLocation("trans_0");
+        mLocations.trans[1]      = mShader->getUniformLocation("trans_1");
+        mLocations.trans[2]      = mShader->getUniformLocation("trans_2");
+        mLocations.trans[3]      = mShader->getUniformLocation("trans_3");
+        mLocations.origin        = mShader->getUniformLocation("origin");
+        mLocations.axisU         = mShader->getUniformLocation("axis_u");
+        mLocations.axisV         = mShader->getUniformLocation("axis_v");
+        mLocations.firstColor    = mShader->getUniformLocation("first_color");
+        mLocations.secondColor   = mShader->getUniformLocation("second_color");
+        mLocations.divergedColor = mShader->getUniformLocation("diverged_color");
+        mLocations.labels        = mShader->getUniformLocation("labels");
+    }
+    if ( mVao )
+        return;
+
+    glGenVertexArrays(1, &mVao);
+
+    // Unknown labels are zero and not drawn until their tile arrives
+    std::vector<GLubyte> unknown(static_cast<size_t>(mResolution) * mResolution,
+                                 BasinMap::UNKNOWN);
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, mResolution, mResolution, 0,
+                 GL_RED, GL_UNSIGNED_BYTE, unknown.data());
+    // Labels must not be blended between texels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return;
+}
+
+void BasinModel::draw(const glm::mat4& viewProjectionMatrix)
+{
+    if ( !mVao )
+        return;
+
+    mShader->use();
+    glm::mat4 mvp = viewProjectionMatrix * getModelMatrix();
+    // Dirty trick to avoid hardware bug
+    for ( GLint i = 0; i < 4; i++ )
+        mShader->setVec4(mLocations.trans[i],
+                         mvp[i][0], mvp[i][1], mvp[i][2], mvp[i][3]);
+    mShader->setVec3(mLocations.origin, mOrigin);
+    mShader->setVec3(mLocations.axisU, mAxisU);
+    mShader->setVec3(mLocations.axisV, mAxisV);
+    mShader->setVec4(mLocations.firstColor, mFirstColor);
+    mShader->setVec4(mLocations.secondColor, mSecondColor);
+    mShader->setVec4(mLocations.divergedColor, mDivergedColor);
+    mShader->setInt(mLocations.labels, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glBindVertexArray(mVao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return;
+}
+
+void BasinModel::clearVertexData()
+{
+    glDeleteVertexArrays(1, &mVao);
+    glDeleteTextures(1, &mTexture);
+    mVao = mTexture = 0;
+}
+
+void BasinModel::updateTile(const BasinMap::Tile& tile)
+{
+    if ( !mTexture )
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, tile.x, tile.y, tile.width, tile.height,
+                    GL_RED, GL_UNSIGNED_BYTE, tile.labels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BasinModel::setColors(const glm::vec4& first, const glm::vec4& second,
+                           const glm::vec4& diverged)
+{
+    mFirstColor = first;
+    mSecondColor = second;
+    mDivergedColor = diverged;
+}
@@ -0,0 +1,307 @@
+#include <algorithm>
+
+#include <chunkedtube.hpp>
+#include <threadpool.hpp>
+
+ChunkedTube::ChunkedTube(const Trajectory& points, const ResidencyBudget& budget)
+    : mPoints(points)
+    , mBudget(budget)
+    , mClock(0)
+    , mCpuBytes(0)
+    , mGpuBytes(0)
+{
+}
+
+ChunkedTube::~ChunkedTube()
+{
+    clear();
+}
+
+void ChunkedTube::invalidateFrom(GLsizei point)
+{
+    // Tangent of point changed, so do transforms of both chunks using it
+    GLsizei chunk = point >= 1 ? chunkOf(point - 1) : 0;
+
+    if ( static_cast<GLsizei>(mTransforms.size()) > chunk ) {
+        mTransforms.resize(chunk);
+        mStarts.resize(chunk);
+        mEndTangents.resize(chunk);
+        mBoundsMin.resize(chunk);
+        mBoundsMax.resize(chunk);
+    }
+
+    for ( auto it = mResident.begin(); it != mResident.end(); ) {
+        if ( it->first < chunk ) {
+            ++it;
+            continue;
+        }
+        releaseGpu(it->second);
+        mCpuBytes -= it->second.frames.size() * sizeof(TubeFrame);
+        it = mResident.erase(it);
+    }
+
+    return;
+}
+
+GLsizei ChunkedTube::chunkOf(GLint segment)
+{
+    return segment / CHUNK_SEGMENTS;
+}
+
+bool ChunkedTube::isVisible(GLsizei chunk, const glm::mat4& mvp, GLfloat radius)
+{
+    scanTo(chunk);
+
+    const glm::vec3 lo = mBoundsMin[chunk] - glm::vec3(radius);
+    const glm::vec3 hi = mBoundsMax[chunk] + glm::vec3(radius);
+
+    // Box is culled if all its corners are outside the same clip plane
+    GLint outside[6] = { 0, 0, 0, 0, 0, 0 };
+    for ( GLint corner = 0; corner < 8; corner++ ) {
+        glm::vec4 p = mvp * glm::vec4(corner & 1 ? hi.x : lo.x,
+                                      corner & 2 ? hi.y : lo.y,
+                                      corner & 4 ? hi.z : lo.z, 1.0f);
+        outside[0] += p.x < -p.w;
+        outside[1] += p.x >  p.w;
+        outside[2] += p.y < -p.w;
+        outside[3] += p.y >  p.w;
+        outside[4] += p.z < -p.w;
+        outside[5] += p.z >  p.w;
+    }
+
+    return std::find(outside, outside + 6, 8) == outside + 6;
+}
+
+void ChunkedTube::acquire(const std::vector<GLsizei>& chunks,
+                          std::vector<const Chunk*>& resident)
+{
+    ++mClock;
+
+    // Frames of missing chunks are independent given scanned starts
+    std::vector<std::pair<GLsizei, Resident*>> missing;
+    for ( GLsizei chunk : chunks ) {
+        scanTo(chunk);
+        Resident& entry = mResident[chunk];
+        bool listed = entry.lastUse == mClock;
+        entry.lastUse = mClock;
+        if ( !listed && entry.frames.empty() && !entry.gpu.positionsVbo )
+            missing.emplace_back(chunk, &entry);
+    }
+
+    ThreadPool::instance().parallelFor(0, missing.size(), 1,
+                                       [&](size_t begin, size_t end) {
+        for ( size_t i = begin; i < end; i++ )
+            computeFrames(missing[i].first, missing[i].second->frames);
+    });
+    for ( const auto& entry : missing )
+        mCpuBytes += entry.second->frames.size() * sizeof(TubeFrame);
+
+    resident.clear();
+    for ( GLsizei chunk : chunks ) {
+        Resident& entry = mResident[chunk];
+        if ( !entry.gpu.positionsVbo ) {
+            // Frames were dropped from CPU cache, so recompute them
+            if ( entry.frames.empty() ) {
+                computeFrames(chunk, entry.frames);
+                mCpuBytes += entry.frames.size() * sizeof(TubeFrame);
+            }
+            upload(entry, chunk);
+        }
+        resident.push_back(&entry.gpu);
+    }
+
+    return;
+}
+
+void ChunkedTube::evict()
+{
+    // Least recently used first, chunks of last acquire are kept
+    auto evictLru = [this](size_t& used, size_t budget, bool gpu)
+    {
+        while ( used > budget ) {
+            Resident* lru = nullptr;
+            for ( auto& entry : mResident ) {
+                Resident& r = entry.second;
+                bool holds = gpu ? r.gpu.positionsVbo != 0 : !r.frames.empty();
+                if ( holds && r.lastUse < mClock && (!lru || r.lastUse < lru->lastUse) )
+                    lru = &r;
+            }
+            if ( !lru )
+                break;
+
+            if ( gpu ) {
+                releaseGpu(*lru);
+            }
+            else {
+                mCpuBytes -= lru->frames.size() * sizeof(TubeFrame);
+                std::vector<TubeFrame>().swap(lru->frames);
+            }
+        }
+    };
+
+    evictLru(mGpuBytes, mBudget.gpuBytes, true);
+    evictLru(mCpuBytes, mBudget.cpuBytes, false);
+
+    for ( auto it = mResident.begin(); it != mResident.end(); ) {
+        if ( !it->second.gpu.positionsVbo && it->second.frames.empty() )
+            it = mResident.erase(it);
+        else
+            ++it;
+    }
+
+    return;
+}
+
+void ChunkedTube::clear()
+{
+    for ( auto& entry : mResident )
+        releaseGpu(entry.second);
+
+    return;
+}
+
+GLsizei ChunkedTube::getNSegments() const
+{
+    return std::max(0, static_cast<GLsizei>(mPoints.size()) - 1);
+}
+
+GLint ChunkedTube::chunkEnd(GLsizei chunk) const
+{
+    return std::min((chunk + 1) * CHUNK_SEGMENTS, getNSegments());
+}
+
+void ChunkedTube::scanTo(GLsizei chunk)
+{
+    const GLsizei scanned = mTransforms.size();
+    if ( chunk < scanned )
+        return;
+
+    const glm::vec3* points = mPoints.data();
+    const GLsizei nPoints = mPoints.size();
+
+    mTransforms.resize(chunk + 1, glm::mat3(1.0f));
+    mStarts.resize(chunk + 1);
+    mEndTangents.resize(chunk + 1);
+    mBoundsMin.resize(chunk + 1);
+    mBoundsMax.resize(chunk + 1);
+
+    // Last valid tangent of each new chunk on its own, zero if it has none
+    std::vector<glm::vec3> lastTangents(chunk + 1 - scanned);
+    ThreadPool::instance().parallelFor(scanned, chunk + 1, 1,
+                                       [&](size_t begin, size_t end) {
+        for ( GLsizei c = begin; c < static_cast<GLsizei>(end); c++ ) {
+            const GLint last = chunkEnd(c);
+            glm::vec3 t(0.0f);
+            for ( GLint i = c * CHUNK_SEGMENTS; i < last; i++ )
+                t = TubeGeometry::tangent(points, nPoints, i, t);
+            lastTangents[c - scanned] = t;
+        }
+    });
+    for ( GLsizei c = scanned; c <= chunk; c++ ) {
+        const glm::vec3& t = lastTangents[c - scanned];
+        mEndTangents[c] = glm::dot(t, t) > 0.0f ? t : carriedTangent(c);
+    }
+
+    // Transforms and bounds of new chunks, each chunk is one task
+    ThreadPool::instance().parallelFor(scanned, chunk + 1, 1,
+                                       [&](size_t begin, size_t end) {
+        for ( GLsizei c = begin; c < static_cast<GLsizei>(end); c++ ) {
+            const GLint first = c * CHUNK_SEGMENTS;
+            const GLint last  = chunkEnd(c);
+
+            glm::mat3 transform(1.0f);
+            glm::vec3 lo = points[first];
+            glm::vec3 hi = points[first];
+            glm::vec3 t0 = TubeGeometry::tangent(points, nPoints, first, carriedTangent(c));
+            for ( GLint i = first; i < last; i++ ) {
+                glm::vec3 t1 = TubeGeometry::tangent(points, nPoints, i + 1, t0);
+                for ( GLint axis = 0; axis < 3; axis++ )
+                    transform[axis] = TubeGeometry::transport(points[i], points[i+1],
+                                                              t0, t1, transform[axis]);
+                lo = glm::min(lo, points[i+1]);
+                hi = glm::max(hi, points[i+1]);
+                t0 = t1;
+            }
+
+            mTransforms[c] = transform;
+            mBoundsMin[c]  = lo;
+            mBoundsMax[c]  = hi;
+        }
+    });
+
+    for ( GLsizei c = scanned; c <= chunk; c++ )
+        mStarts[c] = c == 0
+                   ? TubeGeometry::initialNormal(TubeGeometry::tangent(points, nPoints, 0,
+                                                                       carriedTangent(0)))
+                   : glm::normalize(mTransforms[c-1] * mStarts[c-1]);
+
+    return;
+}
+
+glm::vec3 ChunkedTube::carriedTangent(GLsizei chunk) const
+{
+    return chunk == 0 ? TubeGeometry::DEFAULT_TANGENT : mEndTangents[chunk-1];
+}
+
+void ChunkedTube::computeFrames(GLsizei chunk, std::vector<TubeFrame>& frames) const
+{
+    const glm::vec3* points = mPoints.data();
+    const GLsizei nPoints = mPoints.size();
+    const GLint first = chunk * CHUNK_SEGMENTS;
+    const GLint last  = chunkEnd(chunk);
+
+    // Chunk holds top point of its last segment too
+    frames.resize(last - first + 1);
+
+    glm::vec3 x  = mStarts[chunk];
+    glm::vec3 t0 = TubeGeometry::tangent(points, nPoints, first, carriedTangent(chunk));
+    frames[0] = { x, glm::normalize(glm::cross(t0, x)) };
+    for ( GLint i = first; i < last; i++ ) {
+        glm::vec3 t1 = TubeGeometry::tangent(points, nPoints, i + 1, t0);
+        x = TubeGeometry::transport(points[i], points[i+1], t0, t1, x);
+        frames[i+1-first] = { x, glm::normalize(glm::cross(t1, x)) };
+        t0 = t1;
+    }
+
+    return;
+}
+
+void ChunkedTube::upload(Resident& resident, GLsizei chunk)
+{
+    const GLint first = chunk * CHUNK_SEGMENTS;
+    const GLsizeiptr nPoints = resident.frames.size();
+
+    resident.gpu.firstSegment = first;
+    resident.gpu.nSegments    = nPoints - 1;
+
+    // Points go to GPU straight from their storage
+    glGenBuffers(1, &resident.gpu.positionsVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, resident.gpu.positionsVbo);
+    glBufferData(GL_ARRAY_BUFFER, nPoints * sizeof(glm::vec3),
+                 &mPoints[first], GL_STATIC_DRAW);
+
+    glGenBuffers(1, &resident.gpu.framesVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, resident.gpu.framesVbo);
+    glBufferData(GL_ARRAY_BUFFER, nPoints * sizeof(TubeFrame),
+                 resident.frames.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    mGpuBytes += nPoints * (sizeof(glm::vec3) + sizeof(TubeFrame));
+
+    return;
+}
+
+void ChunkedTube::releaseGpu(Resident& resident)
+{
+    if ( !resident.gpu.positionsVbo )
+        return;
+
+    glDeleteBuffers(1, &resident.gpu.positionsVbo);
+    glDeleteBuffers(1, &resident.gpu.framesVbo);
+    resident.gpu.positionsVbo = resident.gpu.framesVbo = 0;
+
+    mGpuBytes -= (resident.gpu.nSegments + 1) *
+                 (sizeof(glm::vec3) + sizeof(TubeFrame));
+
+    return;
+}
@@ -0,0 +1,86 @@
+#include <cmath>
+#include <random>
+#include <string>
+
+#include <ensemble.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+/// Trajectories per pool task, multiple of every vector width.
+const size_t ENSEMBLE_GRAIN = 64;
+
+}
+
+namespace Ensemble
+{
+
+std::vector<glm::dvec3> initialPoints(const glm::dvec3& center, double radius,
+                                      size_t count, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+
+    std::vector<glm::dvec3> points;
+    points.reserve(count);
+    while (points.size() < count)
+    {
+        glm::dvec3 offset(coordinate(generator),
+                          coordinate(generator),
+                          coordinate(generator));
+        if (glm::dot(offset, offset) <= 1.0)
+            points.push_back(center + radius * offset);
+    }
+    return points;
+}
+
+std::vector<glm::vec3> integrate(const OdeIntegrator::Settings& integration,
+                                 const Settings& settings,
+                                 const std::atomic<bool>& cancelled)
+{
+    const OdeSystem& system = integration.system;
+    const size_t nTrajectories = settings.nTrajectories;
+    const size_t nPoints = settings.nPoints;
+
+    std::vector<glm::dvec3> initial = initialPoints(system.initial, settings.radius,
+                                                    nTrajectories, settings.seed);
+    std::vector<glm::vec3> points(nTrajectories * nPoints);
+    std::atomic<bool> diverged(false);
+
+    ThreadPool::instance().parallelFor(0, nTrajectories, ENSEMBLE_GRAIN,
+                                       [&](size_t begin, size_t end)
+    {
+        if (cancelled.load(std::memory_order_relaxed))
+            return;
+
+        /// Lanes take coordinates as separate arrays.
+        const size_t count = end - begin;
+        std::vector<double> x(count), y(count), z(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            x[i] = initial[begin + i].x;
+            y[i] = initial[begin + i].y;
+            z[i] = initial[begin + i].z;
+        }
+
+        system.rk4Lanes(x.data(), y.data(), z.data(), count,
+                        system.parameters.data(), system.dt,
+                        integration.skip, integration.skip + nPoints, system.scale,
+                        points.data() + begin * nPoints, nPoints);
+
+        /// Non-finite values stay so, checking last points is enough.
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!std::isfinite(x[i] + y[i] + z[i]))
+                diverged = true;
+        }
+    });
+
+    if (diverged)
+        throw std::runtime_error("Ensemble of " + system.name + " diverged");
+
+    return points;
+}
+
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+
+#include <ensemblemodel.hpp>
+
+EnsembleModel::EnsembleModel(std::vector<glm::vec3> points,
+                             GLsizei nTrajectories, GLsizei nPoints)
+    : GLModel()
+    , mColor(1.0f, 1.0f, 1.0f, 1.0f)
+    , mPoints(std::move(points))
+    , mNTrajectories(nTrajectories)
+    , mNPoints(nPoints)
+    , mVao(0)
+    , mVbo(0)
+{
+    configure();
+}
+
+EnsembleModel::~EnsembleModel()
+{
+    clearVertexData();
+}
+
+void EnsembleModel::configure()
+{
+    if ( !mShader ) {
+        mShader = std::make_unique<Shader>("shaders/attractor/vert.glsl",
+                                           "shaders/attractor/frag.glsl");
+        mTransLocations[0] = mShader->getUniformLocation("trans_0");
+        mTransLocations[1] = mShader->getUniformLocation("trans_1");
+        mTransLocations[2] = mShader->getUniformLocation("trans_2");
+        mTransLocations[3] = mShader->getUniformLocation("trans_3");
+        mColorLocation     = mShader->getUniformLocation("color");
+    }
+    if ( mVao || mPoints.empty() )
+        return;
+
+    glGenVertexArrays(1, &mVao);
+    glGenBuffers(1, &mVbo);
+
+    glBindVertexArray(mVao);
+    glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+    glBufferData(GL_ARRAY_BUFFER, mPoints.size() * sizeof(glm::vec3),
+                 mPoints.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // Points are only drawn from now on
+    std::vector<glm::vec3>().swap(mPoints);
+
+    return;
+}
+
+void EnsembleModel::draw(const glm::mat4& viewProjectionMatrix)
+{
+    draw(viewProjectionMatrix, 0, mNPoints - 1);
+    return;
+}
+
+void EnsembleModel::draw(const glm::mat4& viewProjectionMatrix,
+                         GLint from, GLsizei count)
+{
+    from  = std::max(0, from);
+    count = std::min(count, mNPoints - 1 - from);
+    if ( count <= 0 || !mVao )
+        return;
+
+    // One strip of count segments per trajectory
+    mMultiDrawFirsts.resize(mNTrajectories);
+    mMultiDrawCounts.assign(mNTrajectories, count + 1);
+    for ( GLsizei i = 0; i < mNTrajectories; i++ )
+        mMultiDrawFirsts[i] = i * mNPoints + from;
+
+    mShader->use();
+    glm::mat4 mvp = viewProjectionMatrix * getModelMatrix();
+    // Dirty trick to avoid hardware bug
+    for ( GLint i = 0; i < 4; i++ )
+        mShader->setVec4(mTransLocations[i],
+                         mvp[i][0], mvp[i][1], mvp[i][2], mvp[i][3]);
+    mShader->setVec4(mColorLocation, mColor);
+
+    glBindVertexArray(mVao);
+    glMultiDrawArrays(GL_LINE_STRIP, mMultiDrawFirsts.data(),
+                      mMultiDrawCounts.data(), mNTrajectories);
+    glBindVertexArray(0);
+
+    return;
+}
+
+void EnsembleModel::clearVertexData()
+{
+    glDeleteVertexArrays(1, &mVao);
+    glDeleteBuffers(1, &mVbo);
+    mVao = mVbo = 0;
+}
+
+GLsizei EnsembleModel::getNTrajectories() const
+{
+    return mNTrajectories;
+}
+
+GLsizei EnsembleModel::getNPoints() const
+{
+    return mNPoints;
+}
+
+glm::vec4 EnsembleModel::getColor() const
+{
+    return mColor;
+}
+
+void EnsembleModel::setColor(const glm::vec4& color)
+{
+    mColor = color;
+}
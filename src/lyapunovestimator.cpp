@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <lyapunovestimator.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+bool isFinite(const glm::dvec3& x)
+{
+    return std::isfinite(x.x) && std::isfinite(x.y) && std::isfinite(x.z);
+}
+
+/// One RK4 step of state and tangent vectors together.
+void rk4Step(const OdeSystem& system, double h, glm::dvec3& x, glm::dvec3* v)
+{
+    const double* p = system.parameters.data();
+    glm::dvec3 kx[4];
+    glm::dvec3 kv[4][3];
+    glm::dvec3 xs = x;
+    glm::dvec3 vs[3] = { v[0], v[1], v[2] };
+
+    static const double STAGE[3] = { 0.5, 0.5, 1.0 };
+    for ( int s = 0; s < 4; s++ ) {
+        system.tangentRhs(p, xs, vs, kx[s], kv[s]);
+        if ( s == 3 )
+            break;
+        xs = x + STAGE[s] * h * kx[s];
+        for ( int k = 0; k < 3; k++ )
+            vs[k] = v[k] + STAGE[s] * h * kv[s][k];
+    }
+
+    x = x + h / 6.0 * (kx[0] + 2.0 * kx[1] + 2.0 * kx[2] + kx[3]);
+    for ( int k = 0; k < 3; k++ )
+        v[k] = v[k] + h / 6.0 * (kv[0][k] + 2.0 * kv[1][k] + 2.0 * kv[2][k] + kv[3][k]);
+}
+
+}
+
+LyapunovEstimator::LyapunovEstimator(std::vector<Attractor> attractors,
+                                     const Settings& settings)
+    : mAttractors(std::move(attractors))
+    , mSettings(settings)
+    , mEstimates(mAttractors.size())
+{
+    mSettings.nExponents = std::min(3, std::max(1, mSettings.nExponents));
+    mSettings.renormalization = std::max<size_t>(1, mSettings.renormalization);
+    mSettings.sliceSteps = std::max(mSettings.sliceSteps, mSettings.renormalization);
+
+    mJob.start([this]() { run(); });
+}
+
+LyapunovEstimator::~LyapunovEstimator()
+{
+    cancel();
+}
+
+std::vector<LyapunovEstimator::Estimate> LyapunovEstimator::getEstimates()
+{
+    /// Only latest of snapshots pushed since last call matters.
+    std::vector<Estimate> estimates;
+    while (mJob.poll(estimates))
+        mEstimates = std::move(estimates);
+    return mEstimates;
+}
+
+std::string LyapunovEstimator::getError() const
+{
+    return mJob.getError();
+}
+
+void LyapunovEstimator::cancel()
+{
+    mJob.cancel();
+}
+
+void LyapunovEstimator::run()
+{
+    std::vector<State> states(mAttractors.size());
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        states[i].x = mAttractors[i].start;
+        states[i].v[0] = glm::dvec3(1.0, 0.0, 0.0);
+        states[i].v[1] = glm::dvec3(0.0, 1.0, 0.0);
+        states[i].v[2] = glm::dvec3(0.0, 0.0, 1.0);
+    }
+
+    std::vector<Estimate> estimates(states.size());
+    while (!mJob.isCancelled())
+    {
+        /// Attractors are independent, one task each.
+        ThreadPool::instance().parallelFor(0, states.size(), 1,
+                                           [this, &states](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                advance(mAttractors[i], states[i]);
+        });
+
+        for (size_t i = 0; i < states.size(); ++i)
+        {
+            const State& state = states[i];
+            if (state.steps <= mSettings.transient)
+                continue;
+
+            Estimate& estimate = estimates[i];
+            estimate.time = (state.steps - mSettings.transient) * mAttractors[i].system.dt;
+            estimate.exponents.resize(mSettings.nExponents);
+            for (int k = 0; k < mSettings.nExponents; ++k)
+                estimate.exponents[k] = state.logSums[k] / estimate.time;
+        }
+        mJob.push(estimates);
+    }
+}
+
+void LyapunovEstimator::advance(const Attractor& attractor, State& state) const
+{
+    const OdeSystem& system = attractor.system;
+    const size_t renormalization = mSettings.renormalization;
+
+    for (size_t step = 0; step < mSettings.sliceSteps; step += renormalization)
+    {
+        for (size_t i = 0; i < renormalization; ++i)
+            rk4Step(system, system.dt, state.x, state.v);
+        state.steps += renormalization;
+
+        if (!isFinite(state.x))
+            throw std::runtime_error("Trajectory of " + system.name +
+                                     " diverged while estimating Lyapunov exponents");
+
+        /// Gram-Schmidt: stretch of k-th vector orthogonal to previous ones.
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int j = 0; j < k; ++j)
+                state.v[k] = state.v[k] - glm::dot(state.v[k], state.v[j]) * state.v[j];
+
+            double norm = glm::length(state.v[k]);
+            if (!(norm > 0.0) || !std::isfinite(norm))
+                throw std::runtime_error("Tangent vectors of " + system.name +
+                                         " degenerated while estimating Lyapunov exponents");
+            state.v[k] = state.v[k] / norm;
+
+            /// Transient only aligns vectors.
+            if (state.steps > mSettings.transient)
+                state.logSums[k] += std::log(norm);
+        }
+    }
+}
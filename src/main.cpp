@@ -1,17 +1,258 @@
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
 #include <attractorglapp.hpp>
 
+/// Out-of-core budgets unless given on command line.
+static const size_t DFLT_GPU_BUDGET_MB = 1024;
+static const size_t DFLT_CPU_BUDGET_MB = 2048;
+/// Largest budget whose byte count fits in size_t.
+static const long long MAX_BUDGET_MB = static_cast<long long>(SIZE_MAX >> 20);
+/// Basin labels are one texture, its side is limited by common GPUs.
+static const long long MAX_BASIN_RESOLUTION = 16384;
+
+/// Comma-separated numbers, e.g. "0,0,1,0.5".
+static bool parseNumbers(const char* text, float* values, int count)
+{
+    char* end = nullptr;
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] = std::strtof(text, &end);
+        if (end == text || *end != (i + 1 < count ? ',' : '\0'))
+            return false;
+        text = end + 1;
+    }
+    return true;
+}
+
+/// Whole decimal number within [min, max].
+static bool parseInteger(const char* text, long long min, long long max, long long& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtoll(text, &end, 10);
+    return end != text && *end == '\0' && errno != ERANGE && value >= min && value <= max;
+}
+
+/// Finite decimal number.
+static bool parseReal(const char* text, double& value)
+{
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && std::isfinite(value);
+}
+
+static int badValue(const char* option, const char* value)
+{
+    std::cerr << "Bad value of " << option << ": " << value << std::endl;
+    return -1;
+}
+
 int main(int argc, const char** argv)
 {
     AttractorGLApp app(640, 480, "Attractor Viewer");
 
-    if (argc == 5) /// Four args to define attractors trajectories and sections.
+    std::vector<const char*> args;
+    bool fromStdin = false;
+    bool outOfCore = false;
+    ResidencyBudget budget;
+    for (int i = 1; i < argc; ++i)
     {
-        app.setFirstAttractorTrajectory  (argv[1]);
-        app.setFirstAttractorSection     (argv[2]);
-        app.setSecondAttractorTrajectory (argv[3]);
-        app.setSecondAttractorSection    (argv[4]);
+        /// Load cache options.
+        if (std::strcmp(argv[i], "--no-cache") == 0)
+            app.trajectoryCache().setEnabled(false);
+        else if (std::strcmp(argv[i], "--cache-verify") == 0)
+            app.trajectoryCache().setVerifyContent(true);
+        else if (std::strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc)
+            app.trajectoryCache().setDirectory(argv[++i]);
+        /// Out-of-core drawing, budgets in megabytes.
+        else if (std::strcmp(argv[i], "--out-of-core") == 0)
+            outOfCore = true;
+        else if ((std::strcmp(argv[i], "--cpu-budget") == 0 ||
+                  std::strcmp(argv[i], "--gpu-budget") == 0) && i + 1 < argc)
+        {
+            long long megabytes;
+            if (!parseInteger(argv[i + 1], 1, MAX_BUDGET_MB, megabytes))
+                return badValue(argv[i], argv[i + 1]);
+            size_t& bytes = std::strcmp(argv[i], "--cpu-budget") == 0 ? budget.cpuBytes
+                                                                      : budget.gpuBytes;
+            bytes = static_cast<size_t>(megabytes) << 20;
+            ++i;
+        }
+        /// Ensembles of nearby initial conditions around integrated systems.
+        else if ((std::strcmp(argv[i], "--ensemble") == 0 ||
+                  std::strcmp(argv[i], "--ensemble-points") == 0) && i + 1 < argc)
+        {
+            long long count;
+            if (!parseInteger(argv[i + 1], 1, INT_MAX, count))
+                return badValue(argv[i], argv[i + 1]);
+            size_t& setting = std::strcmp(argv[i], "--ensemble") == 0
+                    ? app.ensembleSettings().nTrajectories
+                    : app.ensembleSettings().nPoints;
+            setting = static_cast<size_t>(count);
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--ensemble-radius") == 0 && i + 1 < argc)
+        {
+            double radius;
+            if (!parseReal(argv[i + 1], radius) || !(radius > 0.0))
+                return badValue(argv[i], argv[i + 1]);
+            app.ensembleSettings().radius = radius;
+            ++i;
+        }
+        /// Basins of attraction under system, e.g. --basin ode:coullet
+        else if (std::strcmp(argv[i], "--basin") == 0 && i + 1 < argc)
+            app.setBasinSystem(argv[++i]);
+        else if (std::strcmp(argv[i], "--basin-resolution") == 0 && i + 1 < argc)
+        {
+            long long resolution;
+            if (!parseInteger(argv[i + 1], 1, MAX_BASIN_RESOLUTION, resolution))
+                return badValue(argv[i], argv[i + 1]);
+            app.basinSettings().resolution = static_cast<int>(resolution);
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--basin-size") == 0 && i + 1 < argc)
+        {
+            double halfSize;
+            if (!parseReal(argv[i + 1], halfSize) || !(halfSize > 0.0))
+                return badValue(argv[i], argv[i + 1]);
+            app.basinSettings().halfSize = halfSize;
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--basin-z") == 0 && i + 1 < argc)
+        {
+            double z;
+            if (!parseReal(argv[i + 1], z))
+                return badValue(argv[i], argv[i + 1]);
+            app.basinSettings().center.z = z;
+            ++i;
+        }
+        /// Lyapunov exponents, file attractors need system, e.g. --lyapunov-system ode:coullet
+        else if (std::strcmp(argv[i], "--lyapunov") == 0 && i + 1 < argc)
+        {
+            long long nExponents;
+            if (!parseInteger(argv[i + 1], 1, 3, nExponents))
+                return badValue(argv[i], argv[i + 1]);
+            app.lyapunovSettings().nExponents = static_cast<int>(nExponents);
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--lyapunov-system") == 0 && i + 1 < argc)
+            app.setLyapunovSystem(argv[++i]);
+        /// Poincare sections: plane nx,ny,nz,offset or sphere x,y,z,radius.
+        else if ((std::strcmp(argv[i], "--poincare-plane") == 0 ||
+                  std::strcmp(argv[i], "--poincare-sphere") == 0) && i + 1 < argc)
+        {
+            const bool isPlane = std::strcmp(argv[i], "--poincare-plane") == 0;
+            float values[4];
+            if (!parseNumbers(argv[i + 1], values, 4))
+                return badValue(argv[i], argv[i + 1]);
+            glm::vec3 vector(values[0], values[1], values[2]);
+            app.addPoincareSurface(isPlane
+                    ? PoincareSection::Surface::plane(vector, values[3])
+                    : PoincareSection::Surface::sphere(vector, values[3]));
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--poincare-both") == 0)
+            app.setPoincareDirection(PoincareSection::BOTH);
+        /// Synchronization of attractors, lag is number or "auto".
+        else if (std::strcmp(argv[i], "--sync-threshold") == 0 && i + 1 < argc)
+        {
+            float threshold;
+            if (!parseNumbers(argv[i + 1], &threshold, 1) || !(threshold >= 0.0f))
+                return badValue(argv[i], argv[i + 1]);
+            app.setDistanceThreshold(threshold);
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--sync-lag") == 0 && i + 1 < argc)
+        {
+            ++i;
+            long long lag;
+            if (std::strcmp(argv[i], "auto") == 0)
+                app.setSyncLagEstimated(true);
+            else if (parseInteger(argv[i], PTRDIFF_MIN, PTRDIFF_MAX, lag))
+                app.setSyncLag(static_cast<ptrdiff_t>(lag));
+            else
+                return badValue("--sync-lag", argv[i]);
+        }
+        /// Attractors colored by distance to each other at any time.
+        else if (std::strcmp(argv[i], "--nearest") == 0)
+            app.setNearestApproach(true);
+        /// Recurrence plot of first or second attractor or of both ("cross").
+        else if (std::strcmp(argv[i], "--recurrence") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (std::strcmp(argv[i], "first") == 0)
+                app.setRecurrencePlot(AttractorFilter::FIRST);
+            else if (std::strcmp(argv[i], "second") == 0)
+                app.setRecurrencePlot(AttractorFilter::SECOND);
+            else if (std::strcmp(argv[i], "cross") == 0)
+                app.setRecurrencePlot(AttractorFilter::BOTH);
+            else
+                return badValue("--recurrence", argv[i]);
+        }
+        /// Recurrence distance and samples per axis of coarse texel, positive.
+        else if (std::strcmp(argv[i], "--recurrence-threshold") == 0 && i + 1 < argc)
+        {
+            float threshold;
+            if (!parseNumbers(argv[i + 1], &threshold, 1) || !(threshold > 0.0f))
+                return badValue(argv[i], argv[i + 1]);
+            app.recurrenceSettings().threshold = threshold;
+            ++i;
+        }
+        else if (std::strcmp(argv[i], "--recurrence-samples") == 0 && i + 1 < argc)
+        {
+            long long samples;
+            if (!parseInteger(argv[i + 1], 1, INT_MAX, samples))
+                return badValue(argv[i], argv[i + 1]);
+            app.recurrenceSettings().samples = static_cast<int>(samples);
+            ++i;
+        }
+        /// Uniform lookup counts for profiling shaders.
+        else if (std::strcmp(argv[i], "--report-lookups") == 0)
+            app.setReportUniformLookups(true);
+        /// First trajectory is read live, e.g. integrator | AttractorViewer --stdin
+        else if (std::strcmp(argv[i], "--stdin") == 0)
+            fromStdin = true;
+        else
+            args.push_back(argv[i]);
     }
 
+    if (args.size() == 4) /// Four args to define attractors trajectories and sections.
+    {
+        app.setFirstAttractorTrajectory  (args[0]);
+        app.setFirstAttractorSection     (args[1]);
+        app.setSecondAttractorTrajectory (args[2]);
+        app.setSecondAttractorSection    (args[3]);
+    }
+
+    /// All ensemble points are drawn by one call with GLsizei count.
+    const auto& ensemble = app.ensembleSettings();
+    if (ensemble.nTrajectories > 0 &&
+        ensemble.nPoints > static_cast<size_t>(INT_MAX) / ensemble.nTrajectories)
+    {
+        std::cerr << "Ensemble of " << ensemble.nTrajectories << " trajectories of "
+                  << ensemble.nPoints << " points is too large" << std::endl;
+        return -1;
+    }
+
+    if (outOfCore || budget.gpuBytes > 0 || budget.cpuBytes > 0)
+    {
+        if (budget.gpuBytes == 0)
+            budget.gpuBytes = DFLT_GPU_BUDGET_MB << 20;
+        if (budget.cpuBytes == 0)
+            budget.cpuBytes = DFLT_CPU_BUDGET_MB << 20;
+        app.setResidencyBudget(budget);
+    }
+
+    if (fromStdin)
+        app.setFirstAttractorTrajectory(PipeReader::STDIN_NAME);
+
     app.run();
 
     return 0;
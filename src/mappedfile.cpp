@@ -0,0 +1,65 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mappedfile.hpp>
+
+MappedFile::MappedFile(const std::string& fileName)
+    : mFileName(fileName)
+    , mData(nullptr)
+    , mSize(0)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Can't open file " + fileName);
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) < 0)
+    {
+        close(fd);
+        throw std::runtime_error("Can't stat file " + fileName);
+    }
+    mSize = status.st_size;
+
+    /// Empty file can't be mapped, it is kept as null data.
+    if (mSize > 0)
+    {
+        mData = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mData == MAP_FAILED)
+        {
+            mData = nullptr;
+            close(fd);
+            throw std::runtime_error("Can't map file " + fileName);
+        }
+        madvise(mData, mSize, MADV_SEQUENTIAL | MADV_WILLNEED);
+    }
+
+    /// Mapping stays valid after descriptor is closed.
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        munmap(mData, mSize);
+    }
+}
+
+const char* MappedFile::data() const
+{
+    return static_cast<const char*>(mData);
+}
+
+size_t MappedFile::size() const
+{
+    return mSize;
+}
+
+const std::string& MappedFile::fileName() const
+{
+    return mFileName;
+}
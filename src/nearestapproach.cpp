@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cmath>
+
+#include <nearestapproach.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+/// Points per pool task, each task starts without hint.
+const size_t QUERY_GRAIN = 1 << 14;
+/// Points sampled for bounds of cell size estimate.
+const size_t BOUNDS_SAMPLES = 1 << 16;
+
+}
+
+namespace NearestApproach
+{
+
+float cellSize(const Trajectory& points)
+{
+    if (points.empty())
+        return 1.0f;
+
+    /// Sampled bounds are close enough for cell size.
+    const glm::vec3* data = points.data();
+    const size_t stride = std::max<size_t>(1, points.size() / BOUNDS_SAMPLES);
+    glm::vec3 min = data[0];
+    glm::vec3 max = data[0];
+    for (size_t i = 0; i < points.size(); i += stride)
+    {
+        min = glm::min(min, data[i]);
+        max = glm::max(max, data[i]);
+    }
+
+    /// Trajectory fills little of its box, so cells of cube root of
+    /// points per axis hold few points each.
+    glm::vec3 extent = max - min;
+    float side = std::max(extent.x, std::max(extent.y, extent.z));
+    float size = side / std::cbrt(static_cast<float>(points.size()));
+    return size > 0.0f ? size : 1.0f;
+}
+
+Field compute(const Trajectory& from, const PointGrid& to,
+              const std::atomic<bool>& cancelled)
+{
+    Field field;
+    if (from.empty() || to.empty())
+        return field;
+
+    field.distances.resize(from.size(), 0.0f);
+    const glm::vec3* points = from.data();
+    const glm::vec3* targets = to.getPoints().data();
+    float* distances = field.distances.data();
+    ThreadPool::instance().parallelFor(0, from.size(), QUERY_GRAIN,
+            [&cancelled, &to, points, targets, distances](size_t begin, size_t end)
+    {
+        if ( cancelled.load(std::memory_order_relaxed) )
+            return;
+
+        size_t hint = PointGrid::NONE;
+        for ( size_t i = begin; i < end; i++ ) {
+            hint = to.nearestAny(points[i], hint);
+            distances[i] = hint == PointGrid::NONE ? 0.0f
+                                                   : glm::distance(points[i], targets[hint]);
+        }
+    });
+
+    std::vector<float> sorted = field.distances;
+    auto quantile = sorted.begin() + static_cast<size_t>(SCALE_QUANTILE * (sorted.size() - 1));
+    std::nth_element(sorted.begin(), quantile, sorted.end());
+    field.scale = *quantile;
+
+    return field;
+}
+
+}
@@ -0,0 +1,400 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <mappedfile.hpp>
+#include <npyfile.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+const char NPY_MAGIC[] = "\x93NUMPY";
+
+/// Points per task of conversion to interleaved float.
+const size_t CONVERT_GRAIN = 1 << 16;
+
+struct ArrayView
+{
+    const char* data;
+    size_t size;
+};
+
+struct NpyHeader
+{
+    size_t dataOffset;
+    char type;
+    size_t wordSize;
+    bool fortranOrder;
+    std::vector<size_t> shape;
+};
+
+bool endsWith(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// Range [offset, offset + length) lies within size bytes, without overflow.
+bool fits(uint64_t offset, uint64_t length, uint64_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+template <typename T>
+T readLittleEndian(const char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/// Value of key in header dictionary, e.g. 'descr': '<f4'.
+std::string dictionaryValue(const std::string& header, const std::string& key,
+                            const std::string& fileName)
+{
+    auto keyPos = header.find("'" + key + "'");
+    auto colon = keyPos == std::string::npos ? keyPos : header.find(':', keyPos);
+    if (colon == std::string::npos)
+    {
+        throw std::runtime_error("No '" + key + "' in NumPy header: " + fileName);
+    }
+
+    auto begin = header.find_first_not_of(" ", colon + 1);
+    if (begin == std::string::npos)
+    {
+        throw std::runtime_error("No value of '" + key + "' in NumPy header: " + fileName);
+    }
+    auto end = header[begin] == '(' ? header.find(')', begin)
+                                    : header.find_first_of(",}", begin);
+    if (end == std::string::npos)
+    {
+        throw std::runtime_error("Malformed NumPy header: " + fileName);
+    }
+    return header.substr(begin, end - begin + (header[begin] == '('));
+}
+
+NpyHeader parseHeader(const ArrayView& array, const std::string& fileName)
+{
+    const size_t MAGIC_SIZE = sizeof(NPY_MAGIC) - 1;
+    if (array.size < MAGIC_SIZE + 4 ||
+        std::memcmp(array.data, NPY_MAGIC, MAGIC_SIZE) != 0)
+    {
+        throw std::runtime_error("Not a NumPy array: " + fileName);
+    }
+
+    /// Version 1 has 2-byte header length, versions 2 and 3 have 4-byte one.
+    const int major = static_cast<unsigned char>(array.data[MAGIC_SIZE]);
+    size_t headerSize;
+    size_t headerOffset;
+    if (major == 1)
+    {
+        headerSize = readLittleEndian<uint16_t>(array.data + MAGIC_SIZE + 2);
+        headerOffset = MAGIC_SIZE + 4;
+    }
+    else if (major == 2 || major == 3)
+    {
+        if (array.size < MAGIC_SIZE + 6)
+        {
+            throw std::runtime_error("NumPy array is truncated: " + fileName);
+        }
+        headerSize = readLittleEndian<uint32_t>(array.data + MAGIC_SIZE + 2);
+        headerOffset = MAGIC_SIZE + 6;
+    }
+    else
+    {
+        throw std::runtime_error("Unsupported NumPy format version " +
+                                 std::to_string(major) + ": " + fileName);
+    }
+    if (!fits(headerOffset, headerSize, array.size))
+    {
+        throw std::runtime_error("NumPy array is truncated: " + fileName);
+    }
+
+    std::string header(array.data + headerOffset, headerSize);
+    NpyHeader result;
+    result.dataOffset = headerOffset + headerSize;
+
+    std::string descr = dictionaryValue(header, "descr", fileName);
+    if (descr != "'<f4'" && descr != "'<f8'" && descr != "'=f4'" && descr != "'=f8'")
+    {
+        throw std::runtime_error("Unsupported NumPy dtype " + descr +
+                                 ", expected little-endian float32 or float64: " +
+                                 fileName);
+    }
+    result.type = 'f';
+    result.wordSize = descr[3] - '0';
+
+    result.fortranOrder = dictionaryValue(header, "fortran_order", fileName) == "True";
+
+    std::string shape = dictionaryValue(header, "shape", fileName);
+    for (size_t pos = 1; pos < shape.size(); )
+    {
+        size_t next;
+        try
+        {
+            result.shape.push_back(std::stoull(shape.substr(pos), &next));
+        }
+        catch (std::logic_error&)
+        {
+            break;
+        }
+        pos = shape.find(',', pos + next);
+        pos = pos == std::string::npos ? shape.size() : pos + 1;
+    }
+
+    return result;
+}
+
+/// Arrays of .npz archive. Stored entries only, ZIP64 sizes are supported.
+std::vector<ArrayView> findNpzArrays(const MappedFile& file,
+                                     const std::string& arrayName)
+{
+    const char* data = file.data();
+    const size_t size = file.size();
+    const std::string& fileName = file.fileName();
+
+    const uint32_t EOCD_SIGNATURE      = 0x06054b50;
+    const uint32_t EOCD64_LOCATOR      = 0x07064b50;
+    const uint32_t CENTRAL_SIGNATURE   = 0x02014b50;
+    const uint32_t LOCAL_SIGNATURE     = 0x04034b50;
+    const uint16_t ZIP64_EXTRA_ID      = 0x0001;
+    const size_t   EOCD_SIZE           = 22;
+    const size_t   LOCAL_HEADER_SIZE   = 30;
+    const size_t   CENTRAL_HEADER_SIZE = 46;
+
+    /// End of central directory is followed by comment of up to 64K.
+    size_t eocd = std::string::npos;
+    for (size_t pos = size >= EOCD_SIZE ? size - EOCD_SIZE + 1 : 0; pos-- > 0; )
+    {
+        if (readLittleEndian<uint32_t>(data + pos) == EOCD_SIGNATURE)
+        {
+            eocd = pos;
+            break;
+        }
+        if (size - pos > EOCD_SIZE + 0xFFFF)
+            break;
+    }
+    if (eocd == std::string::npos)
+    {
+        throw std::runtime_error("Not a .npz archive: " + fileName);
+    }
+
+    uint64_t nEntries = readLittleEndian<uint16_t>(data + eocd + 10);
+    uint64_t directory = readLittleEndian<uint32_t>(data + eocd + 16);
+    if (eocd >= 20 && readLittleEndian<uint32_t>(data + eocd - 20) == EOCD64_LOCATOR)
+    {
+        uint64_t eocd64 = readLittleEndian<uint64_t>(data + eocd - 12);
+        if (!fits(eocd64, 56, size))
+        {
+            throw std::runtime_error(".npz archive is truncated: " + fileName);
+        }
+        nEntries = readLittleEndian<uint64_t>(data + eocd64 + 32);
+        directory = readLittleEndian<uint64_t>(data + eocd64 + 48);
+    }
+
+    const std::string wanted = arrayName.empty() ? std::string()
+                                                 : arrayName + NpyFile::NPY_EXTENSION;
+    std::vector<ArrayView> arrays;
+    size_t pos = directory;
+    for (uint64_t entry = 0; entry < nEntries; ++entry)
+    {
+        if (!fits(pos, CENTRAL_HEADER_SIZE, size) ||
+            readLittleEndian<uint32_t>(data + pos) != CENTRAL_SIGNATURE)
+        {
+            throw std::runtime_error(".npz archive is corrupted: " + fileName);
+        }
+
+        uint16_t method        = readLittleEndian<uint16_t>(data + pos + 10);
+        uint64_t storedSize    = readLittleEndian<uint32_t>(data + pos + 20);
+        uint16_t nameSize      = readLittleEndian<uint16_t>(data + pos + 28);
+        uint16_t extraSize     = readLittleEndian<uint16_t>(data + pos + 30);
+        uint16_t commentSize   = readLittleEndian<uint16_t>(data + pos + 32);
+        uint64_t localOffset   = readLittleEndian<uint32_t>(data + pos + 42);
+        uint64_t originalSize  = readLittleEndian<uint32_t>(data + pos + 24);
+        if (!fits(pos + CENTRAL_HEADER_SIZE, nameSize + extraSize + commentSize, size))
+        {
+            throw std::runtime_error(".npz archive is corrupted: " + fileName);
+        }
+        std::string name(data + pos + CENTRAL_HEADER_SIZE, nameSize);
+
+        /// ZIP64 extra field holds only the values saturated in header.
+        const char* extra = data + pos + CENTRAL_HEADER_SIZE + nameSize;
+        for (size_t e = 0; e + 4 <= extraSize; )
+        {
+            uint16_t id = readLittleEndian<uint16_t>(extra + e);
+            uint16_t fieldSize = readLittleEndian<uint16_t>(extra + e + 2);
+            if (!fits(e + 4, fieldSize, extraSize))
+            {
+                throw std::runtime_error(".npz archive is corrupted: " + fileName);
+            }
+            if (id == ZIP64_EXTRA_ID)
+            {
+                const char* field = extra + e + 4;
+                const char* fieldEnd = field + fieldSize;
+                auto readField = [&](uint64_t& value)
+                {
+                    if (value != 0xFFFFFFFF)
+                        return;
+                    if (fieldEnd - field < 8)
+                    {
+                        throw std::runtime_error(".npz archive is corrupted: " + fileName);
+                    }
+                    value = readLittleEndian<uint64_t>(field);
+                    field += 8;
+                };
+                readField(originalSize);
+                readField(storedSize);
+                readField(localOffset);
+            }
+            e += 4 + fieldSize;
+        }
+        pos += CENTRAL_HEADER_SIZE + nameSize + extraSize + commentSize;
+
+        if (!wanted.empty() ? name != wanted : !endsWith(name, NpyFile::NPY_EXTENSION))
+        {
+            continue;
+        }
+
+        if (method != 0)
+        {
+            throw std::runtime_error("Compressed .npz arrays are not supported, "
+                                     "save with np.savez: " + fileName);
+        }
+        if (!fits(localOffset, LOCAL_HEADER_SIZE, size) ||
+            readLittleEndian<uint32_t>(data + localOffset) != LOCAL_SIGNATURE)
+        {
+            throw std::runtime_error(".npz archive is corrupted: " + fileName);
+        }
+
+        uint64_t begin = localOffset + LOCAL_HEADER_SIZE +
+                         readLittleEndian<uint16_t>(data + localOffset + 26) +
+                         readLittleEndian<uint16_t>(data + localOffset + 28);
+        if (!fits(begin, storedSize, size))
+        {
+            throw std::runtime_error(".npz archive is truncated: " + fileName);
+        }
+
+        arrays.push_back({ data + begin, static_cast<size_t>(storedSize) });
+    }
+
+    if (!arrays.empty())
+    {
+        return arrays;
+    }
+    throw std::runtime_error("No array " + (arrayName.empty() ? "" : "'" + arrayName + "' ") +
+                             "in " + fileName);
+}
+
+/// Interleave (and convert) array components into points.
+template <typename T>
+void convert(const char* data, size_t nPoints, bool planar, glm::vec3* points)
+{
+    float* out = &points[0].x;
+    ThreadPool::instance().parallelFor(0, nPoints, CONVERT_GRAIN,
+                                       [&](size_t begin, size_t end)
+    {
+        if (!planar)
+        {
+            /// Flat loop, vectorized by compiler.
+            const T* in = reinterpret_cast<const T*>(data);
+            for (size_t i = 3 * begin; i < 3 * end; ++i)
+                out[i] = static_cast<float>(in[i]);
+            return;
+        }
+
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            const T* in = reinterpret_cast<const T*>(data) + axis * nPoints;
+            for (size_t i = begin; i < end; ++i)
+                out[3 * i + axis] = static_cast<float>(in[i]);
+        }
+    });
+}
+
+}
+
+Trajectory NpyFile::read(const std::string& fileName, const std::string& arrayName)
+{
+    auto file = std::make_shared<const MappedFile>(fileName);
+
+    std::vector<ArrayView> arrays = endsWith(fileName, NPZ_EXTENSION)
+                                  ? findNpzArrays(*file, arrayName)
+                                  : std::vector<ArrayView>{ { file->data(), file->size() } };
+
+    /// First array of archive which has shape of trajectory.
+    ArrayView array;
+    NpyHeader header;
+    bool planar = false;
+    size_t nPoints = 0;
+    bool found = false;
+    for (const ArrayView& candidate : arrays)
+    {
+        array = candidate;
+        header = parseHeader(array, fileName);
+
+        /// (N, 3) is interleaved in C order; (3, N) in C order is planar.
+        if (header.shape.size() == 2 && header.shape[1] == 3)
+        {
+            nPoints = header.shape[0];
+            planar = header.fortranOrder;
+            found = true;
+            break;
+        }
+        if (header.shape.size() == 2 && header.shape[0] == 3 && !header.fortranOrder)
+        {
+            nPoints = header.shape[1];
+            planar = true;
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+    {
+        throw std::runtime_error("NumPy array must have shape (N, 3): " + fileName);
+    }
+
+    const char* data = array.data + header.dataOffset;
+    if (header.dataOffset > array.size ||
+        nPoints > (array.size - header.dataOffset) / (3 * header.wordSize))
+    {
+        throw std::runtime_error("NumPy array is truncated: " + fileName);
+    }
+
+    /// Zero copy: mapping stays alive while trajectory is used.
+    bool aligned = reinterpret_cast<uintptr_t>(data) % alignof(float) == 0;
+    if (header.wordSize == sizeof(float) && !planar && aligned)
+    {
+        return Trajectory(file, reinterpret_cast<const glm::vec3*>(data), nPoints);
+    }
+
+    std::vector<glm::vec3> points(nPoints);
+    if (header.wordSize == sizeof(float) && aligned)
+    {
+        convert<float>(data, nPoints, planar, points.data());
+    }
+    else if (header.wordSize == sizeof(double) &&
+             reinterpret_cast<uintptr_t>(data) % alignof(double) == 0)
+    {
+        convert<double>(data, nPoints, planar, points.data());
+    }
+    else
+    {
+        /// Misaligned archive entry, copy out first.
+        std::vector<double> buffer(nPoints * 3 * header.wordSize / sizeof(double) + 1);
+        std::memcpy(buffer.data(), data, nPoints * 3 * header.wordSize);
+        if (header.wordSize == sizeof(float))
+            convert<float>(reinterpret_cast<const char*>(buffer.data()),
+                           nPoints, planar, points.data());
+        else
+            convert<double>(reinterpret_cast<const char*>(buffer.data()),
+                            nPoints, planar, points.data());
+    }
+
+    return Trajectory(std::move(points));
+}
+
+bool NpyFile::hasExtension(const std::string& fileName)
+{
+    return endsWith(fileName, NPY_EXTENSION) || endsWith(fileName, NPZ_EXTENSION);
+}
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <odeintegrator.hpp>
+
+namespace
+{
+
+/// Points per batch handed to sink.
+const size_t BATCH_POINTS = 1 << 14;
+
+/// Bounds of step size change after one adaptive step.
+const double MIN_STEP_FACTOR = 0.2;
+const double MAX_STEP_FACTOR = 5.0;
+const double STEP_SAFETY = 0.9;
+
+double parseNumber(const std::string& key, const std::string& value)
+{
+    char* end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || !std::isfinite(number))
+        throw std::runtime_error("Bad value of " + key + ": " + value);
+    return number;
+}
+
+size_t parseCount(const std::string& key, const std::string& value)
+{
+    double number = parseNumber(key, value);
+    if (number < 0.0 || number != std::floor(number))
+        throw std::runtime_error("Bad value of " + key + ": " + value);
+    return static_cast<size_t>(number);
+}
+
+bool isFinite(const glm::dvec3& x)
+{
+    return std::isfinite(x.x) && std::isfinite(x.y) && std::isfinite(x.z);
+}
+
+/**
+ * Dormand-Prince 5(4) pair with first same as last stage and
+ * Hairer's fourth order continuous extension for dense output.
+ */
+class DormandPrince
+{
+public:
+    DormandPrince(const OdeSystem& system, const glm::dvec3& x,
+                  double h, double tolerance)
+        : mSystem(system), mTolerance(tolerance),
+          mT(0.0), mH(h), mX(x), mK1(system(x))
+    {
+    }
+
+    /// Take one accepted step, shrinking it as long as error is too big.
+    void step()
+    {
+        /// Systems are autonomous, so stage times are not needed.
+        static const double a21 = 1.0 / 5.0;
+        static const double a31 = 3.0 / 40.0, a32 = 9.0 / 40.0;
+        static const double a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0;
+        static const double a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0,
+                            a53 = 64448.0 / 6561.0, a54 = -212.0 / 729.0;
+        static const double a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0,
+                            a63 = 46732.0 / 5247.0, a64 = 49.0 / 176.0,
+                            a65 = -5103.0 / 18656.0;
+        static const double a71 = 35.0 / 384.0, a73 = 500.0 / 1113.0,
+                            a74 = 125.0 / 192.0, a75 = -2187.0 / 6784.0,
+                            a76 = 11.0 / 84.0;
+        static const double e1 = 71.0 / 57600.0, e3 = -71.0 / 16695.0,
+                            e4 = 71.0 / 1920.0, e5 = -17253.0 / 339200.0,
+                            e6 = 22.0 / 525.0, e7 = -1.0 / 40.0;
+        static const double d1 = -12715105075.0 / 11282082432.0,
+                            d3 = 87487479700.0 / 32700410799.0,
+                            d4 = -10690763975.0 / 1880347072.0,
+                            d5 = 701980252875.0 / 199316789632.0,
+                            d6 = -1453857185.0 / 822651844.0,
+                            d7 = 69997945.0 / 29380423.0;
+
+        while ( true ) {
+            if ( mH <= 1e-14 * std::max(1.0, std::abs(mT)) ) {
+                throw std::runtime_error("Step size underflow of " + mSystem.name +
+                                         " at t = " + std::to_string(mT));
+            }
+
+            const double h = mH;
+            glm::dvec3 k2 = mSystem(mX + h * (a21 * mK1));
+            glm::dvec3 k3 = mSystem(mX + h * (a31 * mK1 + a32 * k2));
+            glm::dvec3 k4 = mSystem(mX + h * (a41 * mK1 + a42 * k2 + a43 * k3));
+            glm::dvec3 k5 = mSystem(mX + h * (a51 * mK1 + a52 * k2 + a53 * k3 + a54 * k4));
+            glm::dvec3 k6 = mSystem(mX + h * (a61 * mK1 + a62 * k2 + a63 * k3 +
+                                              a64 * k4 + a65 * k5));
+            glm::dvec3 x1 = mX + h * (a71 * mK1 + a73 * k3 + a74 * k4 + a75 * k5 + a76 * k6);
+            glm::dvec3 k7 = mSystem(x1);
+
+            glm::dvec3 error = h * (e1 * mK1 + e3 * k3 + e4 * k4 + e5 * k5 +
+                                    e6 * k6 + e7 * k7);
+            double norm = 0.0;
+            for ( int i = 0; i < 3; ++i ) {
+                double scale = mTolerance * (1.0 + std::max(std::abs(mX[i]), std::abs(x1[i])));
+                norm += (error[i] / scale) * (error[i] / scale);
+            }
+            norm = std::sqrt(norm / 3.0);
+
+            if ( !std::isfinite(norm) ) {
+                mH *= MIN_STEP_FACTOR;
+                continue;
+            }
+
+            double factor = norm > 0.0 ? STEP_SAFETY * std::pow(norm, -0.2) : MAX_STEP_FACTOR;
+            factor = std::min(MAX_STEP_FACTOR, std::max(MIN_STEP_FACTOR, factor));
+            if ( norm > 1.0 ) {
+                mH = h * std::min(1.0, factor);
+                continue;
+            }
+
+            /// Coefficients of continuous extension over accepted step.
+            mR1 = mX;
+            mR2 = x1 - mX;
+            mR3 = h * mK1 - mR2;
+            mR4 = mR2 - h * k7 - mR3;
+            mR5 = h * (d1 * mK1 + d3 * k3 + d4 * k4 + d5 * k5 + d6 * k6 + d7 * k7);
+            mT0 = mT;
+
+            mT += h;
+            mX = x1;
+            mK1 = k7;
+            mH = h * factor;
+            return;
+        }
+    }
+
+    /// Point at t within last accepted step.
+    glm::dvec3 interpolate(double t) const
+    {
+        double theta = (t - mT0) / (mT - mT0);
+        double theta1 = 1.0 - theta;
+        return mR1 + theta * (mR2 + theta1 * (mR3 + theta * (mR4 + theta1 * mR5)));
+    }
+
+    double time() const
+    {
+        return mT;
+    }
+
+    const glm::dvec3& point() const
+    {
+        return mX;
+    }
+
+private:
+    const OdeSystem& mSystem;
+    const double mTolerance;
+
+    double mT;
+    double mH;
+    glm::dvec3 mX;
+    glm::dvec3 mK1;
+
+    double mT0 = 0.0;
+    glm::dvec3 mR1, mR2, mR3, mR4, mR5;
+};
+
+}
+
+namespace OdeIntegrator
+{
+
+bool hasPrefix(const std::string& trajectory)
+{
+    return trajectory.compare(0, sizeof(PREFIX) - 1, PREFIX) == 0;
+}
+
+Settings parse(const std::string& trajectory)
+{
+    if (!hasPrefix(trajectory))
+        throw std::runtime_error("Not a system to integrate: " + trajectory);
+
+    std::string spec = trajectory.substr(sizeof(PREFIX) - 1);
+    auto colon = spec.find(':');
+    Settings settings;
+    settings.system = OdeSystem::find(spec.substr(0, colon));
+    if (colon == std::string::npos)
+        return settings;
+
+    std::string options = spec.substr(colon + 1);
+    size_t begin = 0;
+    while (begin < options.size())
+    {
+        size_t end = options.find(',', begin);
+        if (end == std::string::npos)
+            end = options.size();
+        std::string option = options.substr(begin, end - begin);
+        begin = end + 1;
+        if (option.empty())
+            continue;
+
+        auto equals = option.find('=');
+        if (equals == std::string::npos)
+            throw std::runtime_error("Option " + option + " of " + trajectory +
+                                     " has no value");
+        std::string key = option.substr(0, equals);
+        std::string value = option.substr(equals + 1);
+
+        int parameter = settings.system.parameterIndex(key);
+        if (parameter >= 0)
+            settings.system.parameters[parameter] = parseNumber(key, value);
+        else if (key == "x0")
+            settings.system.initial.x = parseNumber(key, value);
+        else if (key == "y0")
+            settings.system.initial.y = parseNumber(key, value);
+        else if (key == "z0")
+            settings.system.initial.z = parseNumber(key, value);
+        else if (key == "dt")
+            settings.system.dt = parseNumber(key, value);
+        else if (key == "scale")
+            settings.system.scale = parseNumber(key, value);
+        else if (key == "n")
+            settings.nPoints = parseCount(key, value);
+        else if (key == "skip")
+            settings.skip = parseCount(key, value);
+        else if (key == "tol")
+            settings.tolerance = parseNumber(key, value);
+        else if (key == "method" && value == "rk4")
+            settings.method = Method::RK4;
+        else if (key == "method" && value == "dopri5")
+            settings.method = Method::DOPRI5;
+        else
+            throw std::runtime_error("Unknown option " + option + " of " + trajectory);
+    }
+
+    if (settings.system.dt <= 0.0 || settings.tolerance <= 0.0 || settings.nPoints == 0)
+        throw std::runtime_error("dt, tol and n of " + trajectory + " must be positive");
+
+    return settings;
+}
+
+glm::dvec3 rk4Step(const OdeSystem& system, const glm::dvec3& x, double h)
+{
+    glm::dvec3 k1 = system(x);
+    glm::dvec3 k2 = system(x + 0.5 * h * k1);
+    glm::dvec3 k3 = system(x + 0.5 * h * k2);
+    glm::dvec3 k4 = system(x + h * k3);
+    return x + h / 6.0 * (k1 + 2.0 * k2 + 2.0 * k3 + k4);
+}
+
+glm::dvec3 integrate(const Settings& settings,
+                     const std::function<bool(std::vector<glm::vec3>)>& sink)
+{
+    const OdeSystem& system = settings.system;
+    const size_t nTotal = settings.skip + settings.nPoints;
+
+    std::vector<glm::vec3> batch;
+    batch.reserve(BATCH_POINTS);
+    /// Points of index below skip are transient and dropped.
+    size_t idx = 0;
+    auto emit = [&](const glm::dvec3& x)
+    {
+        if (!isFinite(x))
+            throw std::runtime_error("Trajectory of " + system.name + " diverged at t = " +
+                                     std::to_string(idx * system.dt));
+        if (idx++ >= settings.skip)
+        {
+            batch.emplace_back(x.x * system.scale, x.y * system.scale, x.z * system.scale);
+            if (batch.size() == BATCH_POINTS)
+            {
+                bool next = sink(std::move(batch));
+                batch.clear();
+                batch.reserve(BATCH_POINTS);
+                return next;
+            }
+        }
+        return true;
+    };
+
+    glm::dvec3 last = system.initial;
+    bool running = emit(last);
+    if (settings.method == Method::RK4)
+    {
+        while (running && idx < nTotal)
+        {
+            last = rk4Step(system, last, system.dt);
+            running = emit(last);
+        }
+    }
+    else
+    {
+        DormandPrince stepper(system, system.initial, system.dt, settings.tolerance);
+        while (running && idx < nTotal)
+        {
+            stepper.step();
+            /// Sample times are multiples of dt so that they do not drift.
+            while (running && idx < nTotal && idx * system.dt <= stepper.time())
+            {
+                last = stepper.interpolate(idx * system.dt);
+                running = emit(last);
+            }
+        }
+    }
+
+    if (running && !batch.empty())
+        sink(std::move(batch));
+
+    return last;
+}
+
+}
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <odesystem.hpp>
+#include <simdpack.hpp>
+
+namespace
+{
+
+/// Right-hand sides are written once for double and DoublePack lanes.
+
+struct Coullet
+{
+    static const int N_PARAMETERS = 4;
+
+    template <typename T>
+    static void eval(const T* p, const T& x, const T& y, const T& z,
+                     T& dx, T& dy, T& dz)
+    {
+        dx = y;
+        dy = z;
+        dz = p[0] * x + p[1] * y + p[2] * z + p[3] * x * x * x;
+    }
+};
+
+struct Lorenz
+{
+    static const int N_PARAMETERS = 3;
+
+    template <typename T>
+    static void eval(const T* p, const T& x, const T& y, const T& z,
+                     T& dx, T& dy, T& dz)
+    {
+        dx = p[0] * (y - x);
+        dy = x * (p[1] - z) - y;
+        dz = x * y - p[2] * z;
+    }
+};
+
+struct Rossler
+{
+    static const int N_PARAMETERS = 3;
+
+    template <typename T>
+    static void eval(const T* p, const T& x, const T& y, const T& z,
+                     T& dx, T& dy, T& dz)
+    {
+        dx = T(0.0) - y - z;
+        dy = x + p[0] * y;
+        dz = p[1] + z * (x - p[2]);
+    }
+};
+
+struct Chen
+{
+    static const int N_PARAMETERS = 3;
+
+    template <typename T>
+    static void eval(const T* p, const T& x, const T& y, const T& z,
+                     T& dx, T& dy, T& dz)
+    {
+        dx = p[0] * (y - x);
+        dy = (p[2] - p[0]) * x - x * z + p[2] * y;
+        dz = x * y - p[1] * z;
+    }
+};
+
+struct Thomas
+{
+    static const int N_PARAMETERS = 1;
+
+    template <typename T>
+    static void eval(const T* p, const T& x, const T& y, const T& z,
+                     T& dx, T& dy, T& dz)
+    {
+        using std::sin;
+        dx = sin(y) - p[0] * x;
+        dy = sin(z) - p[0] * y;
+        dz = sin(x) - p[0] * z;
+    }
+};
+
+const int MAX_PARAMETERS = 4;
+
+template <typename System>
+glm::dvec3 scalarRhs(const glm::dvec3& x, const double* p)
+{
+    glm::dvec3 d;
+    System::eval(p, x.x, x.y, x.z, d.x, d.y, d.z);
+    return d;
+}
+
+/// Value with its derivatives along three tangent vectors.
+struct Jet
+{
+    double v;
+    double d[3];
+
+    Jet(double s = 0.0) : v(s), d{ 0.0, 0.0, 0.0 } {}
+
+    friend Jet operator+(const Jet& a, const Jet& b)
+    {
+        Jet r(a.v + b.v);
+        for ( int k = 0; k < 3; k++ )
+            r.d[k] = a.d[k] + b.d[k];
+        return r;
+    }
+
+    friend Jet operator-(const Jet& a, const Jet& b)
+    {
+        Jet r(a.v - b.v);
+        for ( int k = 0; k < 3; k++ )
+            r.d[k] = a.d[k] - b.d[k];
+        return r;
+    }
+
+    friend Jet operator*(const Jet& a, const Jet& b)
+    {
+        Jet r(a.v * b.v);
+        for ( int k = 0; k < 3; k++ )
+            r.d[k] = a.d[k] * b.v + a.v * b.d[k];
+        return r;
+    }
+};
+
+Jet sin(const Jet& a)
+{
+    Jet r(std::sin(a.v));
+    const double c = std::cos(a.v);
+    for ( int k = 0; k < 3; k++ )
+        r.d[k] = c * a.d[k];
+    return r;
+}
+
+template <typename System>
+void scalarTangent(const double* parameters,
+                   const glm::dvec3& x, const glm::dvec3* v,
+                   glm::dvec3& dx, glm::dvec3* dv)
+{
+    Jet p[MAX_PARAMETERS];
+    for ( int i = 0; i < System::N_PARAMETERS; i++ )
+        p[i] = Jet(parameters[i]);
+
+    Jet jx[3];
+    for ( int i = 0; i < 3; i++ ) {
+        jx[i].v = x[i];
+        for ( int k = 0; k < 3; k++ )
+            jx[i].d[k] = v[k][i];
+    }
+
+    Jet f[3];
+    System::eval(p, jx[0], jx[1], jx[2], f[0], f[1], f[2]);
+
+    for ( int i = 0; i < 3; i++ ) {
+        dx[i] = f[i].v;
+        for ( int k = 0; k < 3; k++ )
+            dv[k][i] = f[i].d[k];
+    }
+}
+
+/// Trajectories of one pack stay in registers for all steps.
+template <typename System, typename Pack>
+void rk4Pack(double* xs, double* ys, double* zs, const double* parameters,
+             double dt, size_t skip, size_t nPoints, double scale,
+             glm::vec3* out, size_t stride)
+{
+    Pack p[MAX_PARAMETERS];
+    for ( int i = 0; i < MAX_PARAMETERS; i++ )
+        p[i] = Pack(parameters[i]);
+
+    const Pack h(dt), half(0.5 * dt), sixth(dt / 6.0), two(2.0);
+    Pack x = Pack::load(xs), y = Pack::load(ys), z = Pack::load(zs);
+    double lanes[3][Pack::SIZE];
+
+    for ( size_t k = 0; k < nPoints; k++ ) {
+        if ( k > 0 ) {
+            Pack k1x, k1y, k1z, k2x, k2y, k2z, k3x, k3y, k3z, k4x, k4y, k4z;
+            System::eval(p, x, y, z, k1x, k1y, k1z);
+            System::eval(p, x + half * k1x, y + half * k1y, z + half * k1z,
+                         k2x, k2y, k2z);
+            System::eval(p, x + half * k2x, y + half * k2y, z + half * k2z,
+                         k3x, k3y, k3z);
+            System::eval(p, x + h * k3x, y + h * k3y, z + h * k3z,
+                         k4x, k4y, k4z);
+            x = x + sixth * (k1x + two * (k2x + k3x) + k4x);
+            y = y + sixth * (k1y + two * (k2y + k3y) + k4y);
+            z = z + sixth * (k1z + two * (k2z + k3z) + k4z);
+        }
+        if ( k < skip )
+            continue;
+
+        x.store(lanes[0]);
+        y.store(lanes[1]);
+        z.store(lanes[2]);
+        for ( int l = 0; l < Pack::SIZE; l++ ) {
+            out[l * stride + k - skip] = glm::vec3(lanes[0][l] * scale,
+                                                   lanes[1][l] * scale,
+                                                   lanes[2][l] * scale);
+        }
+    }
+
+    x.store(xs);
+    y.store(ys);
+    z.store(zs);
+}
+
+template <typename System>
+void rk4Kernel(double* x, double* y, double* z, size_t count,
+              const double* parameters, double dt,
+              size_t skip, size_t nPoints, double scale,
+              glm::vec3* out, size_t stride)
+{
+    double p[MAX_PARAMETERS] = {};
+    std::copy(parameters, parameters + System::N_PARAMETERS, p);
+
+    const size_t width = WideDoublePack::SIZE;
+    size_t i = 0;
+    for ( ; i + width <= count; i += width ) {
+        rk4Pack<System, WideDoublePack>(x + i, y + i, z + i, p, dt, skip, nPoints,
+                                        scale, out + i * stride, stride);
+    }
+    for ( ; i < count; i++ ) {
+        rk4Pack<System, DoublePack<1>>(x + i, y + i, z + i, p, dt, skip, nPoints,
+                                       scale, out + i * stride, stride);
+    }
+}
+
+}
+
+int OdeSystem::parameterIndex(const std::string& parameterName) const
+{
+    for (size_t i = 0; i < parameterNames.size(); ++i)
+    {
+        if (parameterNames[i] == parameterName)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+const OdeSystem& OdeSystem::find(const std::string& name)
+{
+    for (const auto& system : builtIn())
+    {
+        if (system.name == name)
+            return system;
+    }
+
+    std::string known;
+    for (const auto& system : builtIn())
+        known += " " + system.name;
+    throw std::runtime_error("Unknown system " + name + ", known are:" + known);
+}
+
+const std::vector<OdeSystem>& OdeSystem::builtIn()
+{
+    static const std::vector<OdeSystem> systems =
+    {
+        { "coullet", { "a", "b", "c", "d" }, { 0.8, -1.1, -0.45, -1.0 },
+          glm::dvec3(0.1, 0.0, 0.0), 0.01, 1.0,
+          scalarRhs<Coullet>, rk4Kernel<Coullet>, scalarTangent<Coullet> },
+        { "lorenz", { "sigma", "rho", "beta" }, { 10.0, 28.0, 8.0 / 3.0 },
+          glm::dvec3(1.0, 1.0, 1.0), 0.005, 0.05,
+          scalarRhs<Lorenz>, rk4Kernel<Lorenz>, scalarTangent<Lorenz> },
+        { "rossler", { "a", "b", "c" }, { 0.2, 0.2, 5.7 },
+          glm::dvec3(1.0, 1.0, 0.0), 0.02, 0.1,
+          scalarRhs<Rossler>, rk4Kernel<Rossler>, scalarTangent<Rossler> },
+        { "chen", { "a", "b", "c" }, { 35.0, 3.0, 28.0 },
+          glm::dvec3(-0.1, 0.5, -0.6), 0.002, 0.04,
+          scalarRhs<Chen>, rk4Kernel<Chen>, scalarTangent<Chen> },
+        { "thomas", { "b" }, { 0.208186 },
+          glm::dvec3(0.1, 0.0, 0.0), 0.05, 0.3,
+          scalarRhs<Thomas>, rk4Kernel<Thomas>, scalarTangent<Thomas> },
+    };
+    return systems;
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+
+#include <parametercontinuation.hpp>
+
+ParameterContinuation::ParameterContinuation(
+        const OdeIntegrator::Settings& settings, const glm::dvec3& start)
+    : mSettings(settings)
+    , mStart(start)
+    , mGeneration(0)
+    , mStop(false)
+    , mStarted(0)
+    , mFinished(false)
+{
+    mSettings.skip = std::max(mSettings.skip, DFLT_TRANSIENT);
+    mThread = std::thread([this]() { run(); });
+}
+
+ParameterContinuation::~ParameterContinuation()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        ++mGeneration;
+    }
+    mChanged.notify_one();
+    mThread.join();
+}
+
+const OdeIntegrator::Settings& ParameterContinuation::getSettings() const
+{
+    return mSettings;
+}
+
+void ParameterContinuation::setParameter(int idx, double value)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSettings.system.parameters.at(idx) = value;
+        ++mGeneration;
+
+        /// Result not taken yet belongs to previous value.
+        mResult.clear();
+        mFinished = false;
+    }
+    mChanged.notify_one();
+}
+
+bool ParameterContinuation::poll(Trajectory& points)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFinished)
+        return false;
+
+    points = Trajectory(std::move(mResult));
+    mResult.clear();
+    mFinished = false;
+    return true;
+}
+
+bool ParameterContinuation::takeError(std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mError.empty())
+        return false;
+
+    error.swap(mError);
+    mError.clear();
+    return true;
+}
+
+void ParameterContinuation::run()
+{
+    while (true)
+    {
+        OdeIntegrator::Settings settings;
+        uint64_t generation;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mChanged.wait(lock, [this]() { return mStop || mStarted != mGeneration; });
+            if (mStop)
+                return;
+
+            generation = mGeneration;
+            mStarted = generation;
+            settings = mSettings;
+            settings.system.initial = mStart;
+        }
+
+        std::vector<glm::vec3> points;
+        points.reserve(settings.nPoints);
+        try
+        {
+            glm::dvec3 last = OdeIntegrator::integrate(settings,
+                    [this, &points, generation](std::vector<glm::vec3> batch)
+            {
+                points.insert(points.end(), batch.begin(), batch.end());
+                return generation == mGeneration.load();
+            });
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (generation != mGeneration)
+                continue;
+
+            mResult = std::move(points);
+            mStart = last;
+            mFinished = true;
+        }
+        catch (std::exception& exc)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (generation == mGeneration)
+                mError = exc.what();
+        }
+    }
+}
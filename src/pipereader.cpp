@@ -0,0 +1,230 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <pipereader.hpp>
+#include <utils.hpp>
+
+PipeReader::PipeReader(const std::string& fileName)
+    : mFileName(fileName)
+    , mFd(-1)
+    , mRing(RING_CAPACITY)
+    , mCancelled(false)
+    , mDone(false)
+    , mLine(0)
+    , mNMalformed(0)
+{
+    if (fileName == STDIN_NAME)
+    {
+        mFileName = "stdin";
+        mFd = STDIN_FILENO;
+    }
+    else
+    {
+        /// Non-blocking open does not wait for writer to appear.
+        mFd = open(fileName.c_str(), O_RDONLY | O_NONBLOCK);
+        if (mFd < 0)
+        {
+            throw std::runtime_error("Can't open file " + fileName);
+        }
+    }
+
+    mThread = std::thread(&PipeReader::readLoop, this);
+}
+
+PipeReader::~PipeReader()
+{
+    cancel();
+
+    if (mFd >= 0 && mFd != STDIN_FILENO)
+    {
+        close(mFd);
+    }
+}
+
+bool PipeReader::poll(Trajectory& points, size_t maxPoints)
+{
+    if (mScratch.size() < maxPoints)
+    {
+        mScratch.resize(std::min(maxPoints, mRing.capacity()));
+    }
+
+    size_t count = mRing.pop(mScratch.data(), std::min(maxPoints, mScratch.size()));
+    if (count == 0)
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mSpaceMutex);
+        mDrained.notify_one();
+    }
+
+    points = Trajectory(std::vector<glm::vec3>(mScratch.begin(),
+                                               mScratch.begin() + count));
+    return true;
+}
+
+bool PipeReader::isFinished() const
+{
+    return mDone.load() && mRing.empty();
+}
+
+std::string PipeReader::getError() const
+{
+    std::lock_guard<std::mutex> lock(mErrorMutex);
+    return mError;
+}
+
+void PipeReader::cancel()
+{
+    mCancelled = true;
+    {
+        std::lock_guard<std::mutex> lock(mSpaceMutex);
+        mDrained.notify_one();
+    }
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+void PipeReader::readLoop()
+{
+    std::vector<char> buffer(2 * READ_SIZE);
+    std::vector<glm::vec3> points;
+    size_t kept = 0;
+
+    /// Named pipe reads as empty until writer opens it.
+    bool connected = mFd == STDIN_FILENO;
+
+    while (!mCancelled)
+    {
+        /// Waiting with timeout lets cancel() stop silent pipe.
+        pollfd request = { mFd, POLLIN, 0 };
+        int ready = ::poll(&request, 1, POLL_TIMEOUT_MS);
+        if (ready < 0 && errno != EINTR)
+        {
+            std::lock_guard<std::mutex> lock(mErrorMutex);
+            mError = "Can't read " + mFileName + ": " + std::strerror(errno);
+            break;
+        }
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        /// Line longer than buffer makes it grow.
+        if (buffer.size() - kept < READ_SIZE)
+        {
+            buffer.resize(kept + READ_SIZE);
+        }
+
+        ssize_t nRead = read(mFd, buffer.data() + kept, buffer.size() - kept);
+        if (nRead < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            std::lock_guard<std::mutex> lock(mErrorMutex);
+            mError = "Can't read " + mFileName + ": " + std::strerror(errno);
+            break;
+        }
+        if (nRead == 0 && !connected)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+            continue;
+        }
+        connected = true;
+
+        const char* begin = buffer.data();
+        const char* end = begin + kept + nRead;
+        const char* rest = parseLines(begin, end, points);
+
+        /// End of input: last line may have no line break.
+        if (nRead == 0 && rest != end)
+        {
+            parseLine(rest, end, points);
+        }
+        if (!pushPoints(points) || nRead == 0)
+        {
+            break;
+        }
+
+        kept = end - rest;
+        std::memmove(buffer.data(), rest, kept);
+    }
+
+    if (mNMalformed > 0)
+    {
+        std::cerr << mFileName << ": " << mNMalformed
+                  << " malformed line(s) skipped" << std::endl;
+    }
+    mDone = true;
+}
+
+const char* PipeReader::parseLines(const char* begin, const char* end,
+                                   std::vector<glm::vec3>& points)
+{
+    points.clear();
+
+    const char* p = begin;
+    while (const char* lineEnd = static_cast<const char*>(
+                   std::memchr(p, '\n', end - p)))
+    {
+        parseLine(p, lineEnd, points);
+        p = lineEnd + 1;
+    }
+
+    return p;
+}
+
+void PipeReader::parseLine(const char* begin, const char* end,
+                           std::vector<glm::vec3>& points)
+{
+    ++mLine;
+
+    double values[3];
+    int nValues = Utils::parseValues(begin, end, values, 3);
+    if (nValues == 3)
+    {
+        points.emplace_back(values[0], values[1], values[2]);
+    }
+    else if (nValues != 0)
+    {
+        /// Live stream goes on, broken lines are only counted.
+        if (mNMalformed++ == 0)
+        {
+            std::cerr << mFileName << ":" << mLine
+                      << ": malformed point, skipped" << std::endl;
+        }
+    }
+}
+
+bool PipeReader::pushPoints(const std::vector<glm::vec3>& points)
+{
+    for (size_t pushed = 0; pushed < points.size(); )
+    {
+        size_t count = mRing.push(points.data() + pushed, points.size() - pushed);
+        if (count == 0)
+        {
+            /// Retried under lock, so drain signalled meanwhile is not lost.
+            std::unique_lock<std::mutex> lock(mSpaceMutex);
+            mDrained.wait(lock, [&]()
+            {
+                count = mRing.push(points.data() + pushed, points.size() - pushed);
+                return count > 0 || mCancelled;
+            });
+            if (count == 0)
+                return false;
+        }
+        pushed += count;
+    }
+
+    return true;
+}
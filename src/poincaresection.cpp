@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cmath>
+
+#include <poincaresection.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+/// Crossings of value's zero level by segments of points [begin, end).
+template <typename Value>
+void scanCrossings(const glm::vec3* points, size_t begin, size_t end,
+                   PoincareSection::Direction direction,
+                   std::vector<glm::vec3>& crossings, const Value& value)
+{
+    const bool upward = direction != PoincareSection::DOWNWARD;
+    const bool downward = direction != PoincareSection::UPWARD;
+
+    float previous = value(points[begin]);
+    for ( size_t i = begin + 1; i < end; i++ ) {
+        const float current = value(points[i]);
+        const bool crossed = (upward && previous < 0.0f && current >= 0.0f) ||
+                             (downward && previous >= 0.0f && current < 0.0f);
+        if ( crossed ) {
+            const float t = previous / (previous - current);
+            crossings.push_back(points[i - 1] + t * (points[i] - points[i - 1]));
+        }
+        previous = current;
+    }
+}
+
+}
+
+PoincareSection::Surface PoincareSection::Surface::plane(const glm::vec3& normal,
+                                                         float offset)
+{
+    return Surface{ PLANE, normal, glm::vec3(0.0f), offset };
+}
+
+PoincareSection::Surface PoincareSection::Surface::sphere(const glm::vec3& center,
+                                                          float radius)
+{
+    return Surface{ SPHERE, glm::vec3(0.0f), center, radius };
+}
+
+float PoincareSection::Surface::value(const glm::vec3& point) const
+{
+    if (kind == PLANE)
+        return glm::dot(normal, point) - offset;
+
+    /// Squared distances need no root per point.
+    glm::vec3 d = point - center;
+    return glm::dot(d, d) - offset * offset;
+}
+
+void PoincareSection::Surface::range(const glm::vec3& min, const glm::vec3& max,
+                                     float& low, float& high) const
+{
+    if (kind == PLANE)
+    {
+        /// Value at box center plus or minus its largest change over box.
+        glm::vec3 center = 0.5f * (min + max);
+        glm::vec3 extent = 0.5f * (max - min);
+        float mid = value(center);
+        float spread = std::abs(normal.x) * extent.x +
+                       std::abs(normal.y) * extent.y +
+                       std::abs(normal.z) * extent.z;
+        low = mid - spread;
+        high = mid + spread;
+        return;
+    }
+
+    /// Nearest and farthest points of box from sphere center.
+    float nearest = 0.0f;
+    float farthest = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float below = center[i] - min[i];
+        float above = max[i] - center[i];
+        if (below < 0.0f || above < 0.0f)
+            nearest += std::min(below * below, above * above);
+        farthest += std::max(below * below, above * above);
+    }
+    low = nearest - offset * offset;
+    high = farthest - offset * offset;
+}
+
+PoincareSection::PoincareSection()
+    : mDirection(UPWARD)
+    , mNPoints(0)
+    , mFirstDirtyBounds(0)
+    , mFirstDirtyCrossings(0)
+{
+}
+
+void PoincareSection::setSurfaces(std::vector<Surface> surfaces, Direction direction)
+{
+    mSurfaces = std::move(surfaces);
+    mDirection = direction;
+    mFirstDirtyCrossings = 0;
+}
+
+const std::vector<PoincareSection::Surface>& PoincareSection::getSurfaces() const
+{
+    return mSurfaces;
+}
+
+PoincareSection::Direction PoincareSection::getDirection() const
+{
+    return mDirection;
+}
+
+void PoincareSection::invalidate()
+{
+    mNPoints = 0;
+    mFirstDirtyBounds = 0;
+    mFirstDirtyCrossings = 0;
+}
+
+bool PoincareSection::update(const Trajectory& points)
+{
+    if (points.size() != mNPoints)
+    {
+        /// Chunk is dirty if it covers any point past kept ones.
+        const size_t kept = std::min(mNPoints, points.size());
+        const size_t firstDirty = kept == 0 ? 0 : (kept + CHUNK_POINTS - 1) / CHUNK_POINTS - 1;
+        mFirstDirtyBounds = std::min(mFirstDirtyBounds, firstDirty);
+        mFirstDirtyCrossings = std::min(mFirstDirtyCrossings, firstDirty);
+        mNPoints = points.size();
+    }
+
+    const size_t nSegments = mNPoints > 0 ? mNPoints - 1 : 0;
+    const size_t nChunks = (nSegments + CHUNK_POINTS - 1) / CHUNK_POINTS;
+    const bool changed = mFirstDirtyBounds < nChunks ||
+                         mFirstDirtyCrossings < nChunks ||
+                         mChunkMin.size() != nChunks ||
+                         mCrossings.size() != mSurfaces.size();
+    if (!changed)
+        return false;
+
+    mChunkMin.resize(nChunks);
+    mChunkMax.resize(nChunks);
+    mChunkCrossings.resize(mSurfaces.size());
+    for (auto& chunkCrossings : mChunkCrossings)
+        chunkCrossings.resize(nChunks);
+
+    const size_t firstDirtyBounds = std::min(mFirstDirtyBounds, nChunks);
+    const size_t firstDirtyCrossings = std::min(mFirstDirtyCrossings, nChunks);
+    const size_t firstDirty = std::min(firstDirtyBounds, firstDirtyCrossings);
+    ThreadPool::instance().parallelFor(firstDirty, nChunks, CHUNK_GRAIN,
+            [this, &points, firstDirtyBounds, firstDirtyCrossings](size_t begin, size_t end)
+    {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+        {
+            if (chunk >= firstDirtyBounds)
+                computeBounds(points, chunk);
+            if (chunk < firstDirtyCrossings)
+                continue;
+            for (size_t surface = 0; surface < mSurfaces.size(); ++surface)
+                computeCrossings(points, surface, chunk);
+        }
+    });
+    mFirstDirtyBounds = nChunks;
+    mFirstDirtyCrossings = nChunks;
+
+    /// Chunks are joined in order, so crossings stay ordered by time.
+    mCrossings.resize(mSurfaces.size());
+    for (size_t surface = 0; surface < mSurfaces.size(); ++surface)
+    {
+        auto& crossings = mCrossings[surface];
+        crossings.clear();
+        for (const auto& chunkCrossings : mChunkCrossings[surface])
+            crossings.insert(crossings.end(), chunkCrossings.begin(), chunkCrossings.end());
+    }
+
+    return true;
+}
+
+const std::vector<glm::vec3>& PoincareSection::getCrossings(size_t surface) const
+{
+    return mCrossings.at(surface);
+}
+
+void PoincareSection::computeBounds(const Trajectory& points, size_t chunk)
+{
+    const size_t begin = chunk * CHUNK_POINTS;
+    const size_t end = std::min(begin + CHUNK_POINTS + 1, points.size());
+    const glm::vec3* data = points.data();
+
+    glm::vec3 min = data[begin];
+    glm::vec3 max = data[begin];
+    for ( size_t i = begin + 1; i < end; i++ ) {
+        const glm::vec3& p = data[i];
+        min = glm::vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = glm::vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+    mChunkMin[chunk] = min;
+    mChunkMax[chunk] = max;
+}
+
+void PoincareSection::computeCrossings(const Trajectory& points, size_t surface,
+                                       size_t chunk)
+{
+    const Surface& s = mSurfaces[surface];
+    auto& crossings = mChunkCrossings[surface][chunk];
+    crossings.clear();
+
+    /// Whole chunk on one side cannot cross.
+    float low, high;
+    s.range(mChunkMin[chunk], mChunkMax[chunk], low, high);
+    if ( high < 0.0f || low >= 0.0f )
+        return;
+
+    const size_t begin = chunk * CHUNK_POINTS;
+    const size_t end = std::min(begin + CHUNK_POINTS + 1, points.size());
+    const glm::vec3* data = points.data();
+
+    // Kind is resolved once per chunk, not per point
+    if ( s.kind == Surface::PLANE ) {
+        const glm::vec3 normal = s.normal;
+        const float offset = s.offset;
+        scanCrossings(data, begin, end, mDirection, crossings,
+                      [normal, offset](const glm::vec3& p)
+                      { return normal.x * p.x + normal.y * p.y + normal.z * p.z - offset; });
+        return;
+    }
+
+    const glm::vec3 center = s.center;
+    const float radius = s.offset;
+    scanCrossings(data, begin, end, mDirection, crossings,
+                  [center, radius](const glm::vec3& p)
+                  {
+                      glm::vec3 d = p - center;
+                      return d.x * d.x + d.y * d.y + d.z * d.z - radius * radius;
+                  });
+
+    // Value of sphere is not linear along segment, points are put on it
+    for ( auto& crossing : crossings ) {
+        glm::vec3 d = crossing - center;
+        float length = glm::length(d);
+        if ( length > 0.0f )
+            crossing = center + d * (radius / length);
+    }
+}
@@ -0,0 +1,116 @@
+#include <pointcloudmodel.hpp>
+
+PointCloudModel::PointCloudModel()
+    : GLModel()
+    , mColor(1.0f, 1.0f, 1.0f, 1.0f)
+    , mPointSize(DFLT_POINT_SIZE)
+    , mVao(0)
+    , mVbo(0)
+    , mVboCapacity(0)
+    , mNPoints(0)
+{
+    configure();
+}
+
+PointCloudModel::~PointCloudModel()
+{
+    clearVertexData();
+}
+
+void PointCloudModel::configure()
+{
+    if ( !mShader ) {
+        mShader = std::make_unique<Shader>("shaders/attractor/vert.glsl",
+                                           "shaders/attractor/frag.glsl");
+        mTransLocations[0] = mShader->getUniformLocation("trans_0");
+        mTransLocations[1] = mShader->getUniformLocation("trans_1");
+        mTransLocations[2] = mShader->getUniformLocation("trans_2");
+        mTransLocations[3] = mShader->getUniformLocation("trans_3");
+        mColorLocation     = mShader->getUniformLocation("color");
+    }
+    if ( mVao )
+        return;
+
+    glGenVertexArrays(1, &mVao);
+    glGenBuffers(1, &mVbo);
+
+    glBindVertexArray(mVao);
+    glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    return;
+}
+
+void PointCloudModel::draw(const glm::mat4& viewProjectionMatrix)
+{
+    if ( mNPoints == 0 || !mVao )
+        return;
+
+    mShader->use();
+    glm::mat4 mvp = viewProjectionMatrix * getModelMatrix();
+    // Dirty trick to avoid hardware bug
+    for ( GLint i = 0; i < 4; i++ )
+        mShader->setVec4(mTransLocations[i],
+                         mvp[i][0], mvp[i][1], mvp[i][2], mvp[i][3]);
+    mShader->setVec4(mColorLocation, mColor);
+
+    glPointSize(mPointSize);
+    glBindVertexArray(mVao);
+    glDrawArrays(GL_POINTS, 0, mNPoints);
+    glBindVertexArray(0);
+
+    return;
+}
+
+void PointCloudModel::clearVertexData()
+{
+    glDeleteVertexArrays(1, &mVao);
+    glDeleteBuffers(1, &mVbo);
+    mVao = mVbo = 0;
+    mVboCapacity = 0;
+    mNPoints = 0;
+}
+
+void PointCloudModel::setPoints(const std::vector<glm::vec3>& points)
+{
+    mNPoints = static_cast<GLsizei>(points.size());
+    if ( points.empty() || !mVao )
+        return;
+
+    const GLsizeiptr size = points.size() * sizeof(glm::vec3);
+    glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+    if ( size > mVboCapacity ) {
+        // Room for growth while section is moved or trajectory streams
+        mVboCapacity = 2 * size;
+        glBufferData(GL_ARRAY_BUFFER, mVboCapacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, points.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLsizei PointCloudModel::getNPoints() const
+{
+    return mNPoints;
+}
+
+glm::vec4 PointCloudModel::getColor() const
+{
+    return mColor;
+}
+
+void PointCloudModel::setColor(const glm::vec4& color)
+{
+    mColor = color;
+}
+
+GLfloat PointCloudModel::getPointSize() const
+{
+    return mPointSize;
+}
+
+void PointCloudModel::setPointSize(GLfloat size)
+{
+    mPointSize = size;
+}
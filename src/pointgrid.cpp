@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <pointgrid.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+/// Points per task of parallel key computation.
+const size_t KEY_GRAIN = 1 << 16;
+
+/**
+ * Sort blocks in parallel, then merge pairs of sorted runs level by level,
+ * each level in parallel, ping-ponging between items and scratch.
+ */
+template <typename T>
+void parallelSort(std::vector<T>& items)
+{
+    const size_t n = items.size();
+    const size_t nBlocks = (n + KEY_GRAIN - 1) / KEY_GRAIN;
+    ThreadPool& pool = ThreadPool::instance();
+    pool.parallelFor(0, n, KEY_GRAIN, [&items](size_t begin, size_t end)
+    {
+        std::sort(items.begin() + begin, items.begin() + end);
+    });
+    if (nBlocks <= 1)
+        return;
+
+    std::vector<T> scratch(n);
+    std::vector<T>* from = &items;
+    std::vector<T>* to = &scratch;
+    for (size_t run = KEY_GRAIN; run < n; run *= 2)
+    {
+        const size_t nPairs = (n + 2 * run - 1) / (2 * run);
+        pool.parallelFor(0, nPairs, 1, [from, to, run, n](size_t pair, size_t)
+        {
+            const size_t begin = pair * 2 * run;
+            const size_t middle = std::min(begin + run, n);
+            const size_t end = std::min(begin + 2 * run, n);
+            std::merge(from->begin() + begin, from->begin() + middle,
+                       from->begin() + middle, from->begin() + end,
+                       to->begin() + begin);
+        });
+        std::swap(from, to);
+    }
+    if (from != &items)
+        items.swap(scratch);
+}
+
+}
+
+PointGrid::PointGrid()
+    : mCellSize(1.0f)
+    , mMin(0.0f)
+    , mMax(0.0f)
+{
+}
+
+PointGrid::PointGrid(Trajectory points, float cellSize)
+    : mPoints(std::move(points))
+    , mCellSize(cellSize)
+    , mMin(0.0f)
+    , mMax(0.0f)
+{
+    if (!(cellSize > 0.0f))
+        throw std::runtime_error("Cell size of point grid must be positive");
+    if (mPoints.empty())
+        return;
+
+    /// Bounds of blocks are computed in parallel and then joined.
+    const size_t nBlocks = (mPoints.size() + KEY_GRAIN - 1) / KEY_GRAIN;
+    std::vector<glm::vec3> blockMin(nBlocks, mPoints[0]);
+    std::vector<glm::vec3> blockMax(nBlocks, mPoints[0]);
+    ThreadPool::instance().parallelFor(0, mPoints.size(), KEY_GRAIN,
+                                       [&](size_t begin, size_t end)
+    {
+        glm::vec3 min = mPoints[begin];
+        glm::vec3 max = mPoints[begin];
+        for (size_t i = begin + 1; i < end; ++i)
+        {
+            min = glm::min(min, mPoints[i]);
+            max = glm::max(max, mPoints[i]);
+        }
+        blockMin[begin / KEY_GRAIN] = min;
+        blockMax[begin / KEY_GRAIN] = max;
+    });
+    mMin = blockMin[0];
+    mMax = blockMax[0];
+    for (size_t i = 1; i < nBlocks; ++i)
+    {
+        mMin = glm::min(mMin, blockMin[i]);
+        mMax = glm::max(mMax, blockMax[i]);
+    }
+
+    glm::vec3 extent = mMax - mMin;
+    float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+    const float maxCells = static_cast<float>((1 << KEY_BITS) - 1);
+    mCellSize = std::max(mCellSize, maxExtent / maxCells);
+
+    /// Keys are computed in parallel, sorting groups points of each cell.
+    const size_t nPoints = mPoints.size();
+    std::vector<std::pair<uint64_t, size_t>> keys(nPoints);
+    ThreadPool::instance().parallelFor(0, nPoints, KEY_GRAIN,
+                                       [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            keys[i] = std::make_pair(keyOf(cellOf(mPoints[i])), i);
+    });
+    parallelSort(keys);
+
+    mOrder.resize(nPoints);
+    mSorted.resize(nPoints);
+    ThreadPool::instance().parallelFor(0, nPoints, KEY_GRAIN,
+                                       [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            mOrder[i] = keys[i].second;
+            mSorted[i] = mPoints[keys[i].second];
+        }
+    });
+
+    /// Only first point of every cell touches hash map.
+    size_t cellBegin = 0;
+    for (size_t i = 1; i <= nPoints; ++i)
+    {
+        if (i < nPoints && keys[i].first == keys[cellBegin].first)
+            continue;
+        mCells.emplace(keys[cellBegin].first, std::make_pair(cellBegin, i));
+        cellBegin = i;
+    }
+}
+
+size_t PointGrid::nearest(const glm::vec3& point, float maxDistance) const
+{
+    if (mPoints.empty())
+        return NONE;
+
+    /// Points farther than maxDistance from bounds cannot match,
+    /// comparisons are written so that NaN coordinates fail them too.
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!(point[i] >= mMin[i] - maxDistance && point[i] <= mMax[i] + maxDistance))
+            return NONE;
+    }
+
+    const int reach = static_cast<int>(std::ceil(maxDistance / mCellSize));
+    const glm::ivec3 center = cellOf(point);
+    const int maxCell = (1 << KEY_BITS) - 1;
+
+    size_t best = NONE;
+    float bestDistance2 = maxDistance * maxDistance;
+    for (int dz = -reach; dz <= reach; ++dz)
+    {
+        for (int dy = -reach; dy <= reach; ++dy)
+        {
+            for (int dx = -reach; dx <= reach; ++dx)
+            {
+                glm::ivec3 cell(center.x + dx, center.y + dy, center.z + dz);
+                if (cell.x < 0 || cell.y < 0 || cell.z < 0 ||
+                    cell.x > maxCell || cell.y > maxCell || cell.z > maxCell)
+                    continue;
+
+                auto found = mCells.find(keyOf(cell));
+                if (found == mCells.end())
+                    continue;
+
+                for (size_t i = found->second.first; i < found->second.second; ++i)
+                {
+                    glm::vec3 d = mSorted[i] - point;
+                    float distance2 = glm::dot(d, d);
+                    if (distance2 <= bestDistance2)
+                    {
+                        bestDistance2 = distance2;
+                        best = mOrder[i];
+                    }
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+size_t PointGrid::nearestAny(const glm::vec3& point, size_t hint) const
+{
+    if (mPoints.empty())
+        return NONE;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (std::isnan(point[i]))
+            return NONE;
+    }
+
+    /// Point outside bounds starts from nearest border cell.
+    const int maxCell = (1 << KEY_BITS) - 1;
+    glm::ivec3 center = cellOf(point);
+    glm::ivec3 nCells;
+    for (int i = 0; i < 3; ++i)
+    {
+        nCells[i] = std::min(maxCell, static_cast<int>((mMax[i] - mMin[i]) / mCellSize)) + 1;
+        center[i] = std::min(center[i], nCells[i] - 1);
+    }
+
+    size_t best = NONE;
+    float bestDistance2 = std::numeric_limits<float>::infinity();
+    if (hint < mPoints.size())
+    {
+        glm::vec3 d = mPoints[hint] - point;
+        best = hint;
+        bestDistance2 = glm::dot(d, d);
+    }
+    for (int reach = 0; ; ++reach)
+    {
+        /// Cells at Chebyshev distance reach from center, clipped to grid.
+        glm::ivec3 low, high;
+        for (int i = 0; i < 3; ++i)
+        {
+            low[i] = std::max(center[i] - reach, 0);
+            high[i] = std::min(center[i] + reach, nCells[i] - 1);
+        }
+        for (int z = low.z; z <= high.z; ++z)
+        {
+            for (int y = low.y; y <= high.y; ++y)
+            {
+                const bool inside = std::abs(z - center.z) < reach &&
+                                    std::abs(y - center.y) < reach;
+                /// Inner rows only have two cells on shell.
+                const int step = inside ? std::max(1, 2 * reach) : 1;
+                for (int x = center.x - reach; x <= center.x + reach; x += step)
+                {
+                    if (x < low.x || x > high.x)
+                        continue;
+
+                    auto found = mCells.find(keyOf(glm::ivec3(x, y, z)));
+                    if (found == mCells.end())
+                        continue;
+
+                    for (size_t i = found->second.first; i < found->second.second; ++i)
+                    {
+                        glm::vec3 d = mSorted[i] - point;
+                        float distance2 = glm::dot(d, d);
+                        if (distance2 < bestDistance2)
+                        {
+                            bestDistance2 = distance2;
+                            best = mOrder[i];
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Unvisited points lie beyond some face of visited cells.
+        bool unvisited = false;
+        float bound = std::numeric_limits<float>::infinity();
+        for (int i = 0; i < 3; ++i)
+        {
+            if (low[i] > 0)
+            {
+                unvisited = true;
+                bound = std::min(bound, std::max(0.0f, point[i] - (mMin[i] + low[i] * mCellSize)));
+            }
+            if (high[i] < nCells[i] - 1)
+            {
+                unvisited = true;
+                bound = std::min(bound, std::max(0.0f, mMin[i] + (high[i] + 1) * mCellSize - point[i]));
+            }
+        }
+        if (!unvisited || (best != NONE && bestDistance2 <= bound * bound))
+            return best;
+    }
+}
+
+const Trajectory& PointGrid::getPoints() const
+{
+    return mPoints;
+}
+
+float PointGrid::getCellSize() const
+{
+    return mCellSize;
+}
+
+bool PointGrid::empty() const
+{
+    return mPoints.empty();
+}
+
+glm::ivec3 PointGrid::cellOf(const glm::vec3& point) const
+{
+    /// Clamped, so that points just outside bounds map to border cells.
+    const float maxCell = static_cast<float>((1 << KEY_BITS) - 1);
+    glm::ivec3 cell;
+    for (int i = 0; i < 3; ++i)
+    {
+        float c = std::floor((point[i] - mMin[i]) / mCellSize);
+        cell[i] = static_cast<int>(std::min(std::max(c, 0.0f), maxCell));
+    }
+    return cell;
+}
+
+uint64_t PointGrid::keyOf(const glm::ivec3& cell)
+{
+    return static_cast<uint64_t>(cell.x) |
+           static_cast<uint64_t>(cell.y) << KEY_BITS |
+           static_cast<uint64_t>(cell.z) << 2 * KEY_BITS;
+}
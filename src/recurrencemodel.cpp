@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cmath>
+
+#include <recurrencemodel.hpp>
+
+RecurrenceModel::RecurrenceModel(size_t width, size_t height, int topLevel)
+    : GLModel()
+    , mWidth(width)
+    , mHeight(height)
+    , mTopLevel(topLevel)
+    , mCenter(0.5f, 0.5f)
+    , mHalfSize(0.5f)
+    , mPixels(1)
+    , mRecurrentColor(0.0f, 0.0f, 0.0f, 1.0f)
+    , mBackgroundColor(1.0f, 1.0f, 1.0f, 1.0f)
+    , mFrame(0)
+    , mVao(0)
+    , mTexture(0)
+{
+    configure();
+}
+
+RecurrenceModel::~RecurrenceModel()
+{
+    clearVertexData();
+}
+
+void RecurrenceModel::configure()
+{
+    if ( !mShader ) {
+        mShader = std::make_unique<Shader>("shaders/recurrence/vert.glsl",
+                                           "shaders/recurrence/frag.glsl");
+        mLocations.trans[0]        = mShader->getUniformLocation("trans_0");
+        mLocations.trans[1]        = mShader->getUniformLocation("trans_1");
+        mLocations.trans[2]        = mShader->getUniformLocation("trans_2");
+        mLocations.trans[3]        = mShader->getUniformLocation("trans_3");
+        mLocations.rect            = mShader->getUniformLocation("rect");
+        mLocations.texRect         = mShader->getUniformLocation("tex_rect");
+        mLocations.layer           = mShader->getUniformLocation("layer");
+        mLocations.recurrentColor  = mShader->getUniformLocation("recurrent_color");
+        mLocations.backgroundColor = mShader->getUniformLocation("background_color");
+        mLocations.rates           = mShader->getUniformLocation("rates");
+    }
+    if ( mVao )
+        return;
+
+    glGenVertexArrays(1, &mVao);
+
+    // Layers are filled as tiles arrive
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8,
+                 RecurrencePlot::TILE_SIZE, RecurrencePlot::TILE_SIZE, CACHE_TILES,
+                 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    // Texels are point pairs, they are not blended when zoomed in
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    mSlots.clear();
+    mFreeLayers.clear();
+    for ( GLint layer = CACHE_TILES - 1; layer >= 0; layer-- )
+        mFreeLayers.push_back(layer);
+
+    return;
+}
+
+void RecurrenceModel::draw(const glm::mat4& viewProjectionMatrix)
+{
+    if ( !mVao )
+        return;
+    mFrame++;
+
+    // View square of plot is mapped onto [-1, 1]^2
+    glm::mat4 view(1.0f);
+    view[0][0] = 1.0f / mHalfSize;
+    view[1][1] = 1.0f / mHalfSize;
+    view[3][0] = -mCenter.x / mHalfSize;
+    view[3][1] = -mCenter.y / mHalfSize;
+
+    mShader->use();
+    glm::mat4 mvp = viewProjectionMatrix * view;
+    // Dirty trick to avoid hardware bug
+    for ( GLint i = 0; i < 4; i++ )
+        mShader->setVec4(mLocations.trans[i],
+                         mvp[i][0], mvp[i][1], mvp[i][2], mvp[i][3]);
+    mShader->setVec4(mLocations.recurrentColor, mRecurrentColor);
+    mShader->setVec4(mLocations.backgroundColor, mBackgroundColor);
+    mShader->setInt(mLocations.rates, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+    glBindVertexArray(mVao);
+
+    const int level = viewLevel();
+    glm::ivec2 first, last;
+    visibleTiles(level, first, last);
+    for ( int y = first.y; y <= last.y; y++ ) {
+        for ( int x = first.x; x <= last.x; x++ ) {
+            // Missing tile is drawn from part of nearest cached ancestor
+            RecurrencePlot::TileKey key{ level, x, y };
+            auto slot = mSlots.end();
+            int up = 0;
+            for ( ; level + up <= mTopLevel; up++ ) {
+                slot = mSlots.find(RecurrencePlot::TileKey{ level + up, x >> up, y >> up });
+                if ( slot != mSlots.end() )
+                    break;
+            }
+            if ( slot == mSlots.end() )
+                continue;
+            slot->second.used = mFrame;
+
+            const GLfloat part = 1.0f / static_cast<GLfloat>(1 << up);
+            const GLfloat u = (x & ((1 << up) - 1)) * part;
+            const GLfloat v = (y & ((1 << up) - 1)) * part;
+            mShader->setVec4(mLocations.rect, tileRect(key));
+            mShader->setVec4(mLocations.texRect, glm::vec4(u, v, u + part, v + part));
+            mShader->setInt(mLocations.layer, slot->second.layer);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return;
+}
+
+void RecurrenceModel::clearVertexData()
+{
+    glDeleteVertexArrays(1, &mVao);
+    glDeleteTextures(1, &mTexture);
+    mVao = mTexture = 0;
+    mSlots.clear();
+    mFreeLayers.clear();
+}
+
+void RecurrenceModel::updateTile(const RecurrencePlot::Tile& tile)
+{
+    if ( !mTexture )
+        return;
+
+    // Least recently drawn tile gives its layer away
+    auto slot = mSlots.find(tile.key);
+    if ( slot == mSlots.end() ) {
+        GLint layer;
+        if ( !mFreeLayers.empty() ) {
+            layer = mFreeLayers.back();
+            mFreeLayers.pop_back();
+        }
+        else {
+            auto oldest = std::min_element(mSlots.begin(), mSlots.end(),
+                    [](const std::pair<const RecurrencePlot::TileKey, Slot>& a,
+                       const std::pair<const RecurrencePlot::TileKey, Slot>& b)
+                    { return a.second.used < b.second.used; });
+            layer = oldest->second.layer;
+            mSlots.erase(oldest);
+        }
+        slot = mSlots.emplace(tile.key, Slot{ layer, mFrame }).first;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, slot->second.layer,
+                    RecurrencePlot::TILE_SIZE, RecurrencePlot::TILE_SIZE, 1,
+                    GL_RED, GL_UNSIGNED_BYTE, tile.rates.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void RecurrenceModel::setViewportSize(GLsizei pixels)
+{
+    mPixels = std::max(1, pixels);
+}
+
+std::vector<RecurrencePlot::TileKey> RecurrenceModel::missingTiles() const
+{
+    const int level = viewLevel();
+    glm::ivec2 first, last;
+    visibleTiles(level, first, last);
+    std::vector<RecurrencePlot::TileKey> visible;
+    for ( int y = first.y; y <= last.y; y++ ) {
+        for ( int x = first.x; x <= last.x; x++ ) {
+            RecurrencePlot::TileKey key{ level, x, y };
+            if ( level != mTopLevel && !mSlots.count(key) )
+                visible.push_back(key);
+        }
+    }
+
+    // Tiles near view center first
+    auto centerDistance = [this](const RecurrencePlot::TileKey& key)
+    {
+        glm::vec4 rect = tileRect(key);
+        glm::vec2 d = 0.5f * glm::vec2(rect.x + rect.z, rect.y + rect.w) - mCenter;
+        return glm::dot(d, d);
+    };
+    std::stable_sort(visible.begin(), visible.end(),
+                     [&centerDistance](const RecurrencePlot::TileKey& a,
+                                       const RecurrencePlot::TileKey& b)
+    {
+        return centerDistance(a) < centerDistance(b);
+    });
+
+    // Whole plot is there to fall back on while visible tiles come
+    std::vector<RecurrencePlot::TileKey> missing;
+    RecurrencePlot::TileKey top{ mTopLevel, 0, 0 };
+    if ( !mSlots.count(top) )
+        missing.push_back(top);
+    missing.insert(missing.end(), visible.begin(), visible.end());
+    return missing;
+}
+
+void RecurrenceModel::zoom(GLfloat factor)
+{
+    // Closest view shows a few points at many pixels each
+    const GLfloat side = static_cast<GLfloat>(std::max(std::max(mWidth, mHeight),
+                                                       static_cast<size_t>(1)));
+    const GLfloat minHalfSize = std::min(0.5f, 0.5f * mPixels / (MAX_POINT_PIXELS * side));
+    mHalfSize = std::max(minHalfSize, std::min(0.5f, mHalfSize / factor));
+    pan(glm::vec2(0.0f));
+}
+
+void RecurrenceModel::pan(const glm::vec2& delta)
+{
+    mCenter += 2.0f * mHalfSize * delta;
+    mCenter.x = std::max(mHalfSize, std::min(1.0f - mHalfSize, mCenter.x));
+    mCenter.y = std::max(mHalfSize, std::min(1.0f - mHalfSize, mCenter.y));
+}
+
+void RecurrenceModel::setColors(const glm::vec4& recurrent, const glm::vec4& background)
+{
+    mRecurrentColor = recurrent;
+    mBackgroundColor = background;
+}
+
+int RecurrenceModel::viewLevel() const
+{
+    const double side = static_cast<double>(std::max(mWidth, mHeight));
+    const double pointsPerPixel = 2.0 * mHalfSize * side / mPixels;
+    int level = 0;
+    while ( level < mTopLevel && static_cast<double>(1 << level) < pointsPerPixel )
+        level++;
+    return level;
+}
+
+void RecurrenceModel::visibleTiles(int level, glm::ivec2& first, glm::ivec2& last) const
+{
+    const double tilePoints = static_cast<double>(RecurrencePlot::TILE_SIZE) * (1 << level);
+    const double sizes[2] = { static_cast<double>(mWidth), static_cast<double>(mHeight) };
+    for ( int i = 0; i < 2; i++ ) {
+        const int nTiles = std::max(1, static_cast<int>(std::ceil(sizes[i] / tilePoints)));
+        const double low = (mCenter[i] - mHalfSize) * sizes[i] / tilePoints;
+        const double high = (mCenter[i] + mHalfSize) * sizes[i] / tilePoints;
+        first[i] = std::max(0, std::min(nTiles - 1, static_cast<int>(std::floor(low))));
+        last[i] = std::max(0, std::min(nTiles - 1, static_cast<int>(std::floor(high))));
+    }
+}
+
+glm::vec4 RecurrenceModel::tileRect(const RecurrencePlot::TileKey& key) const
+{
+    const GLfloat tilePoints = static_cast<GLfloat>(RecurrencePlot::TILE_SIZE) * (1 << key.level);
+    const GLfloat width = static_cast<GLfloat>(std::max(mWidth, static_cast<size_t>(1)));
+    const GLfloat height = static_cast<GLfloat>(std::max(mHeight, static_cast<size_t>(1)));
+    return glm::vec4(key.x * tilePoints / width, key.y * tilePoints / height,
+                     (key.x + 1) * tilePoints / width, (key.y + 1) * tilePoints / height);
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <recurrenceplot.hpp>
+#include <simdpack.hpp>
+#include <threadpool.hpp>
+
+namespace
+{
+
+/**
+ * Add to counts[j] number of rows closer than threshold to point j,
+ * points and rows given by coordinate arrays. NaN points never recur.
+ */
+void countRecurrences(const float* xs, const float* ys, const float* zs, size_t n,
+                      const std::vector<glm::vec3>& rows, float threshold,
+                      int32_t* counts)
+{
+    const float threshold2 = threshold * threshold;
+    size_t j = 0;
+#ifdef SIMDPACK_SSE
+    // Four points at once, their counts stay in register over rows
+    const __m128 t2 = _mm_set1_ps(threshold2);
+    for ( ; j + 4 <= n; j += 4 ) {
+        const __m128 x = _mm_loadu_ps(xs + j);
+        const __m128 y = _mm_loadu_ps(ys + j);
+        const __m128 z = _mm_loadu_ps(zs + j);
+        __m128i count = _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + j));
+        for ( const glm::vec3& row : rows ) {
+            __m128 dx = _mm_sub_ps(x, _mm_set1_ps(row.x));
+            __m128 dy = _mm_sub_ps(y, _mm_set1_ps(row.y));
+            __m128 dz = _mm_sub_ps(z, _mm_set1_ps(row.z));
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                   _mm_mul_ps(dz, dz));
+            // Mask of recurrent lanes is -1, false for NaN
+            count = _mm_sub_epi32(count, _mm_castps_si128(_mm_cmple_ps(d2, t2)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(counts + j), count);
+    }
+#endif
+    for ( ; j < n; j++ ) {
+        for ( const glm::vec3& row : rows ) {
+            float dx = xs[j] - row.x;
+            float dy = ys[j] - row.y;
+            float dz = zs[j] - row.z;
+            counts[j] += dx * dx + dy * dy + dz * dz <= threshold2;
+        }
+    }
+}
+
+}
+
+bool RecurrencePlot::TileKey::operator==(const TileKey& other) const
+{
+    return level == other.level && x == other.x && y == other.y;
+}
+
+bool RecurrencePlot::TileKey::operator<(const TileKey& other) const
+{
+    if (level != other.level)
+        return level < other.level;
+    if (y != other.y)
+        return y < other.y;
+    return x < other.x;
+}
+
+RecurrencePlot::RecurrencePlot(Trajectory first, Trajectory second,
+                               const Settings& settings)
+    : mFirst(std::move(first))
+    , mSecond(std::move(second))
+    , mSettings(settings)
+    , mTopLevel(0)
+{
+    if (!(mSettings.threshold > 0.0f) || mSettings.samples <= 0)
+        throw std::runtime_error("Recurrence threshold and samples must be positive");
+
+    const size_t side = std::max(mFirst.size(), mSecond.size());
+    while ((static_cast<size_t>(TILE_SIZE) << mTopLevel) < side)
+        ++mTopLevel;
+
+    mJob.start([this]() { run(); });
+}
+
+RecurrencePlot::~RecurrencePlot()
+{
+    cancel();
+}
+
+size_t RecurrencePlot::getWidth() const
+{
+    return mFirst.size();
+}
+
+size_t RecurrencePlot::getHeight() const
+{
+    return mSecond.size();
+}
+
+int RecurrencePlot::getTopLevel() const
+{
+    return mTopLevel;
+}
+
+const RecurrencePlot::Settings& RecurrencePlot::getSettings() const
+{
+    return mSettings;
+}
+
+void RecurrencePlot::request(const std::vector<TileKey>& keys)
+{
+    mJob.update([this, &keys]()
+    {
+        mRequests.clear();
+        for (const auto& key : keys)
+        {
+            if (!mComputing.count(key))
+                mRequests.push_back(key);
+        }
+    });
+}
+
+bool RecurrencePlot::poll(Tile& tile)
+{
+    return mJob.poll(tile);
+}
+
+std::string RecurrencePlot::getError() const
+{
+    return mJob.getError();
+}
+
+void RecurrencePlot::cancel()
+{
+    mJob.cancel();
+}
+
+void RecurrencePlot::run()
+{
+    /// One tile per pool thread at a time, so that new requests are
+    /// taken soon after view changes.
+    const size_t batchSize = std::max(1u, ThreadPool::instance().getNThreads());
+    std::vector<Tile> batch;
+    while (true)
+    {
+        bool requested = mJob.waitUntil([this, &batch, batchSize]()
+        {
+            while (!mRequests.empty() && batch.size() < batchSize)
+            {
+                Tile tile;
+                tile.key = mRequests.front();
+                mRequests.pop_front();
+                mComputing.insert(tile.key);
+                batch.push_back(std::move(tile));
+            }
+            return !batch.empty();
+        });
+        if (!requested)
+            return;
+
+        ThreadPool::instance().parallelFor(0, batch.size(), 1,
+                                           [this, &batch](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                computeTile(batch[i]);
+        });
+
+        /// Tiles are out before they stop counting as computed, so that
+        /// requests in between don't ask for them again.
+        std::vector<TileKey> keys;
+        for (auto& tile : batch)
+        {
+            keys.push_back(tile.key);
+            mJob.push(std::move(tile));
+        }
+        batch.clear();
+        mJob.update([this, &keys]()
+        {
+            for (const auto& key : keys)
+                mComputing.erase(key);
+        });
+    }
+}
+
+void RecurrencePlot::computeTile(Tile& tile) const
+{
+    const TileKey key = tile.key;
+    const size_t step = static_cast<size_t>(1) << key.level;
+    const size_t samples = std::min(step, static_cast<size_t>(mSettings.samples));
+    const size_t sub = step / samples;
+    const size_t tileSize = TILE_SIZE;
+
+    /// Sampled points of texel columns, samples of column side by side.
+    /// Missing points are NaN, so they never recur.
+    const size_t n = tileSize * samples;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::vector<float> xs(n, nan), ys(n, nan), zs(n, nan);
+    std::vector<int32_t> nColumnSamples(tileSize, 0);
+    const glm::vec3* first = mFirst.data();
+    for ( size_t c = 0; c < tileSize; c++ ) {
+        const size_t base = (key.x * tileSize + c) * step + sub / 2;
+        for ( size_t k = 0; k < samples; k++ ) {
+            const size_t index = base + k * sub;
+            if ( index >= mFirst.size() )
+                break;
+            xs[c * samples + k] = first[index].x;
+            ys[c * samples + k] = first[index].y;
+            zs[c * samples + k] = first[index].z;
+            nColumnSamples[c]++;
+        }
+    }
+
+    tile.rates.assign(tileSize * tileSize, 0);
+    std::vector<glm::vec3> rows;
+    std::vector<int32_t> counts(n);
+    const glm::vec3* second = mSecond.data();
+    for ( size_t r = 0; r < tileSize; r++ ) {
+        const size_t base = (key.y * tileSize + r) * step + sub / 2;
+        rows.clear();
+        for ( size_t k = 0; k < samples; k++ ) {
+            const size_t index = base + k * sub;
+            if ( index >= mSecond.size() )
+                break;
+            rows.push_back(second[index]);
+        }
+        if ( rows.empty() )
+            break;
+
+        std::fill(counts.begin(), counts.end(), 0);
+        countRecurrences(xs.data(), ys.data(), zs.data(), n, rows,
+                         mSettings.threshold, counts.data());
+
+        uint8_t* rates = tile.rates.data() + r * tileSize;
+        for ( size_t c = 0; c < tileSize; c++ ) {
+            const int32_t nPairs = nColumnSamples[c] * static_cast<int32_t>(rows.size());
+            if ( nPairs == 0 )
+                break;
+            int32_t recurrent = 0;
+            for ( size_t k = 0; k < samples; k++ )
+                recurrent += counts[c * samples + k];
+            rates[c] = static_cast<uint8_t>((recurrent * 255 + nPairs / 2) / nPairs);
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #include <shader.hpp>
 
+Shader::LookupCounters Shader::sLookupCounters = { 0, 0 };
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath) throw(std::ifstream::failure)
 {
     std::string vertexCode;
@@ -61,6 +63,8 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath) throw(std::ifst
      */
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    reflectUniforms();
 }
 
 void Shader::use()
@@ -73,78 +77,161 @@ unsigned int Shader::getID()
     return mID;
 }
 
+int Shader::getUniformLocation(const std::string& name) const
+{
+    ++sLookupCounters.cached;
+
+    auto it = mUniformLocations.find(name);
+    return it != mUniformLocations.end() ? it->second : -1;
+}
+
+Shader::LookupCounters Shader::getLookupCounters()
+{
+    return sLookupCounters;
+}
+
+void Shader::resetLookupCounters()
+{
+    sLookupCounters = { 0, 0 };
+}
+
 void Shader::setBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(mID, name.c_str()),
+    glUniform1i(getUniformLocation(name),
                 static_cast<int>(value));
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(mID, name.c_str()),
+    glUniform1i(getUniformLocation(name),
                 value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-    glUniform1f(glGetUniformLocation(mID, name.c_str()),
+    glUniform1f(getUniformLocation(name),
                 value);
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const
 {
-    glUniform2fv(glGetUniformLocation(mID, name.c_str()),
+    glUniform2fv(getUniformLocation(name),
                  1, &value[0]);
 }
 
 void Shader::setVec2(const std::string& name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(mID, name.c_str()),
+    glUniform2f(getUniformLocation(name),
                 x, y);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(mID, name.c_str()),
+    glUniform3fv(getUniformLocation(name),
                  1, &value[0]);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(mID, name.c_str()),
+    glUniform3f(getUniformLocation(name),
                 x, y, z);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const
 {
-    glUniform4fv(glGetUniformLocation(mID, name.c_str()),
+    glUniform4fv(getUniformLocation(name),
                  1, &value[0]);
 }
 
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(mID, name.c_str()),
+    glUniform4f(getUniformLocation(name),
                 x, y, z, w);
 }
 
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(mID, name.c_str()),
+    glUniformMatrix2fv(getUniformLocation(name),
                        1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(mID, name.c_str()),
+    glUniformMatrix3fv(getUniformLocation(name),
                        1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(mID, name.c_str()),
+    glUniformMatrix4fv(getUniformLocation(name),
                        1, GL_FALSE, &mat[0][0]);
 }
 
+void Shader::setBool(int location, bool value) const
+{
+    glUniform1i(location, static_cast<int>(value));
+}
+
+void Shader::setInt(int location, int value) const
+{
+    glUniform1i(location, value);
+}
+
+void Shader::setFloat(int location, float value) const
+{
+    glUniform1f(location, value);
+}
+
+void Shader::setVec2(int location, const glm::vec2& value) const
+{
+    glUniform2fv(location, 1, &value[0]);
+}
+
+void Shader::setVec2(int location, float x, float y) const
+{
+    glUniform2f(location, x, y);
+}
+
+void Shader::setVec2Array(int location, const glm::vec2* values, int count) const
+{
+    glUniform2fv(location, count, &values[0][0]);
+}
+
+void Shader::setVec3(int location, const glm::vec3& value) const
+{
+    glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::setVec3(int location, float x, float y, float z) const
+{
+    glUniform3f(location, x, y, z);
+}
+
+void Shader::setVec4(int location, const glm::vec4& value) const
+{
+    glUniform4fv(location, 1, &value[0]);
+}
+
+void Shader::setVec4(int location, float x, float y, float z, float w) const
+{
+    glUniform4f(location, x, y, z, w);
+}
+
+void Shader::setMat2(int location, const glm::mat2& mat) const
+{
+    glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat3(int location, const glm::mat3& mat) const
+{
+    glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4(int location, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+}
+
 void Shader::checkCompileErrors(unsigned int shader, Shader::SHADER_TYPE type)
 {
     int success;
@@ -169,3 +256,30 @@ void Shader::checkCompileErrors(unsigned int shader, Shader::SHADER_TYPE type)
         }
     }
 }
+
+void Shader::reflectUniforms()
+{
+    int nUniforms = 0;
+    glGetProgramiv(mID, GL_ACTIVE_UNIFORMS, &nUniforms);
+
+    char name[BUFFER_SIZE];
+    for (int i = 0; i < nUniforms; ++i)
+    {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(mID, i, BUFFER_SIZE, &length, &size, &type, name);
+
+        int location = glGetUniformLocation(mID, name);
+        ++sLookupCounters.driver;
+        mUniformLocations.emplace(std::string(name, length), location);
+
+        /// Arrays are reported as "name[0]", allow plain "name" as well.
+        std::string arrayName(name, length);
+        auto bracket = arrayName.find('[');
+        if (bracket != std::string::npos)
+        {
+            mUniformLocations.emplace(arrayName.substr(0, bracket), location);
+        }
+    }
+}
@@ -0,0 +1,269 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <shmring.hpp>
+
+namespace
+{
+
+/// Records start on their own page.
+const uint64_t DATA_OFFSET = 4096;
+
+static_assert(sizeof(ShmRing::Header) <= DATA_OFFSET, "Header overlaps records");
+
+/// Producer back-off while reader drains full ring.
+const std::chrono::microseconds FULL_RING_SLEEP(200);
+
+/// Copy count records from ring position, wrapping around its end.
+void copyFromRing(const glm::vec3* records, uint64_t capacity, uint64_t position,
+                  glm::vec3* out, size_t count)
+{
+    size_t offset = position & (capacity - 1);
+    size_t first = std::min<size_t>(count, capacity - offset);
+    std::memcpy(out, records + offset, first * sizeof(glm::vec3));
+    std::memcpy(out + first, records, (count - first) * sizeof(glm::vec3));
+}
+
+void copyToRing(glm::vec3* records, uint64_t capacity, uint64_t position,
+                const glm::vec3* in, size_t count)
+{
+    size_t offset = position & (capacity - 1);
+    size_t first = std::min<size_t>(count, capacity - offset);
+    std::memcpy(records + offset, in, first * sizeof(glm::vec3));
+    std::memcpy(records, in + first, (count - first) * sizeof(glm::vec3));
+}
+
+}
+
+bool ShmRing::hasPrefix(const std::string& trajectory)
+{
+    return trajectory.compare(0, sizeof(PREFIX) - 1, PREFIX) == 0;
+}
+
+std::string ShmRing::segmentName(const std::string& trajectory)
+{
+    std::string name = hasPrefix(trajectory)
+                     ? trajectory.substr(sizeof(PREFIX) - 1)
+                     : trajectory;
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+ShmRingProducer::ShmRingProducer(const std::string& name, size_t capacity)
+    : mName(ShmRing::segmentName(name))
+    , mCachedRead(0)
+{
+    uint64_t records = 1;
+    while (records < capacity)
+        records <<= 1;
+    mSize = DATA_OFFSET + records * sizeof(glm::vec3);
+
+    /// Segment left by crashed producer is replaced.
+    shm_unlink(mName.c_str());
+    int fd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Can't create shared memory " + mName + ": " +
+                                 std::strerror(errno));
+    }
+    if (ftruncate(fd, mSize) != 0)
+    {
+        ::close(fd);
+        shm_unlink(mName.c_str());
+        throw std::runtime_error("Can't resize shared memory " + mName);
+    }
+
+    void* data = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        shm_unlink(mName.c_str());
+        throw std::runtime_error("Can't map shared memory " + mName);
+    }
+
+    mHeader = new (data) ShmRing::Header();
+    mHeader->version    = ShmRing::VERSION;
+    mHeader->capacity   = records;
+    mHeader->recordSize = sizeof(glm::vec3);
+    mHeader->dataOffset = DATA_OFFSET;
+    mHeader->writeCursor.store(0);
+    mHeader->readCursor.store(0);
+    mHeader->closed.store(0);
+    mRecords = reinterpret_cast<glm::vec3*>(static_cast<char*>(data) + DATA_OFFSET);
+
+    /// Magic is written last, reader checks it before anything else.
+    mHeader->magic.store(ShmRing::MAGIC, std::memory_order_release);
+}
+
+ShmRingProducer::~ShmRingProducer()
+{
+    close();
+
+    /// Attached reader keeps its mapping after unlink.
+    munmap(mHeader, mSize);
+    shm_unlink(mName.c_str());
+}
+
+void ShmRingProducer::write(const glm::vec3* points, size_t count)
+{
+    const uint64_t capacity = mHeader->capacity;
+    while (count > 0)
+    {
+        uint64_t write = mHeader->writeCursor.load(std::memory_order_relaxed);
+        if (write - mCachedRead == capacity)
+        {
+            mCachedRead = mHeader->readCursor.load(std::memory_order_acquire);
+            if (write - mCachedRead == capacity)
+            {
+                /// Reader is another process, so full ring is polled.
+                std::this_thread::sleep_for(FULL_RING_SLEEP);
+                continue;
+            }
+        }
+
+        size_t n = std::min<uint64_t>(count, capacity - (write - mCachedRead));
+        copyToRing(mRecords, capacity, write, points, n);
+        mHeader->writeCursor.store(write + n, std::memory_order_release);
+
+        points += n;
+        count -= n;
+    }
+}
+
+void ShmRingProducer::close()
+{
+    mHeader->closed.store(1, std::memory_order_release);
+}
+
+bool ShmRingProducer::isDrained() const
+{
+    return mHeader->readCursor.load(std::memory_order_acquire) ==
+           mHeader->writeCursor.load(std::memory_order_relaxed);
+}
+
+ShmRingReader::ShmRingReader(const std::string& name)
+    : mName(ShmRing::segmentName(name))
+    , mSize(0)
+    , mHeader(nullptr)
+    , mRecords(nullptr)
+{
+}
+
+ShmRingReader::~ShmRingReader()
+{
+    cancel();
+}
+
+bool ShmRingReader::poll(Trajectory& points, size_t maxPoints)
+{
+    if (!mHeader && !attach())
+    {
+        return false;
+    }
+
+    /// Read cursor is written by this side only.
+    uint64_t read = mHeader->readCursor.load(std::memory_order_relaxed);
+    uint64_t write = mHeader->writeCursor.load(std::memory_order_acquire);
+    size_t count = std::min<uint64_t>(write - read, maxPoints);
+    if (count == 0)
+    {
+        return false;
+    }
+
+    std::vector<glm::vec3> taken(count);
+    copyFromRing(mRecords, mHeader->capacity, read, taken.data(), count);
+    mHeader->readCursor.store(read + count, std::memory_order_release);
+
+    points = Trajectory(std::move(taken));
+    return true;
+}
+
+bool ShmRingReader::isFinished() const
+{
+    return mHeader && mHeader->closed.load(std::memory_order_acquire) &&
+           mHeader->readCursor.load(std::memory_order_relaxed) ==
+           mHeader->writeCursor.load(std::memory_order_acquire);
+}
+
+std::string ShmRingReader::getError() const
+{
+    return mError;
+}
+
+void ShmRingReader::cancel()
+{
+    if (mHeader)
+    {
+        munmap(mHeader, mSize);
+        mHeader = nullptr;
+        mRecords = nullptr;
+    }
+}
+
+bool ShmRingReader::attach()
+{
+    if (!mError.empty())
+    {
+        return false;
+    }
+
+    int fd = shm_open(mName.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        /// Producer has not started yet.
+        if (errno != ENOENT)
+            mError = "Can't open shared memory " + mName + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 ||
+        static_cast<size_t>(status.st_size) < DATA_OFFSET)
+    {
+        /// Producer may be between creating and resizing segment.
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = status.st_size;
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        mError = "Can't map shared memory " + mName;
+        return false;
+    }
+
+    auto* header = static_cast<ShmRing::Header*>(data);
+    if (header->magic.load(std::memory_order_acquire) != ShmRing::MAGIC)
+    {
+        munmap(data, size);
+        return false;
+    }
+
+    if (header->version != ShmRing::VERSION ||
+        header->recordSize != sizeof(glm::vec3) ||
+        header->dataOffset != DATA_OFFSET ||
+        header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0 ||
+        header->capacity > (size - DATA_OFFSET) / sizeof(glm::vec3))
+    {
+        munmap(data, size);
+        mError = "Incompatible shared memory ring " + mName;
+        return false;
+    }
+
+    mSize = size;
+    mHeader = header;
+    mRecords = reinterpret_cast<const glm::vec3*>(static_cast<char*>(data) + DATA_OFFSET);
+    return true;
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <simdpack.hpp>
+#include <syncdistance.hpp>
+#include <threadpool.hpp>
+
+SyncDistance::SyncDistance()
+    : mLag(0)
+{
+}
+
+void SyncDistance::setLag(ptrdiff_t lag)
+{
+    mLag = lag;
+    invalidate();
+}
+
+ptrdiff_t SyncDistance::getLag() const
+{
+    return mLag;
+}
+
+size_t SyncDistance::getFirstOffset() const
+{
+    return mLag < 0 ? static_cast<size_t>(-mLag) : 0;
+}
+
+size_t SyncDistance::getSecondOffset() const
+{
+    return mLag > 0 ? static_cast<size_t>(mLag) : 0;
+}
+
+void SyncDistance::invalidate()
+{
+    mDistances.clear();
+}
+
+bool SyncDistance::update(const Trajectory& first, const Trajectory& second)
+{
+    const size_t firstOffset = getFirstOffset();
+    const size_t secondOffset = getSecondOffset();
+    if (first.size() <= firstOffset || second.size() <= secondOffset)
+        return false;
+
+    const size_t nAligned = std::min(first.size() - firstOffset,
+                                     second.size() - secondOffset);
+    const size_t from = mDistances.size();
+    if (nAligned <= from)
+        return false;
+
+    mDistances.resize(nAligned);
+    const glm::vec3* a = first.data() + firstOffset;
+    const glm::vec3* b = second.data() + secondOffset;
+    float* out = mDistances.data();
+    ThreadPool::instance().parallelFor(from, nAligned, GRAIN,
+                                       [a, b, out](size_t begin, size_t end)
+    {
+        distances(a + begin, b + begin, out + begin, end - begin);
+    });
+
+    return true;
+}
+
+const std::vector<float>& SyncDistance::getDistances() const
+{
+    return mDistances;
+}
+
+size_t SyncDistance::size() const
+{
+    return mDistances.size();
+}
+
+size_t SyncDistance::firstDivergence(float threshold) const
+{
+    auto it = std::find_if(mDistances.begin(), mDistances.end(),
+                           [threshold](float distance) { return distance > threshold; });
+    return it - mDistances.begin();
+}
+
+double SyncDistance::synchronizedFraction(float threshold) const
+{
+    if (mDistances.empty())
+        return 0.0;
+
+    const size_t nTasks = (mDistances.size() + GRAIN - 1) / GRAIN;
+    std::vector<size_t> counts(nTasks, 0);
+    const float* distances = mDistances.data();
+    ThreadPool::instance().parallelFor(0, mDistances.size(), GRAIN,
+            [distances, threshold, &counts](size_t begin, size_t end)
+    {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i)
+            count += distances[i] <= threshold;
+        counts[begin / GRAIN] = count;
+    });
+
+    size_t synchronized = 0;
+    for (size_t count : counts)
+        synchronized += count;
+    return static_cast<double>(synchronized) / mDistances.size();
+}
+
+ptrdiff_t SyncDistance::estimateLag(const Trajectory& first, const Trajectory& second,
+                                    size_t maxLag, size_t window)
+{
+    const ptrdiff_t nLags = 2 * static_cast<ptrdiff_t>(maxLag) + 1;
+    std::vector<double> means(nLags, std::numeric_limits<double>::infinity());
+
+    ThreadPool::instance().parallelFor(0, nLags, 1,
+            [&first, &second, &means, maxLag, window](size_t begin, size_t end)
+    {
+        std::vector<float> scratch;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const ptrdiff_t lag = static_cast<ptrdiff_t>(i) - static_cast<ptrdiff_t>(maxLag);
+            const size_t firstOffset = lag < 0 ? -lag : 0;
+            const size_t secondOffset = lag > 0 ? lag : 0;
+            if (first.size() <= firstOffset || second.size() <= secondOffset)
+                continue;
+
+            const size_t n = std::min(window, std::min(first.size() - firstOffset,
+                                                       second.size() - secondOffset));
+            scratch.resize(n);
+            distances(first.data() + firstOffset, second.data() + secondOffset,
+                      scratch.data(), n);
+
+            double sum = 0.0;
+            for (float distance : scratch)
+                sum += distance;
+            means[i] = sum / n;
+        }
+    });
+
+    /// Ties go to lag closest to zero.
+    ptrdiff_t best = 0;
+    for (ptrdiff_t i = 0; i < nLags; ++i)
+    {
+        const ptrdiff_t lag = i - static_cast<ptrdiff_t>(maxLag);
+        const double bestMean = means[best + maxLag];
+        if (means[i] < bestMean || (means[i] == bestMean && std::abs(lag) < std::abs(best)))
+            best = lag;
+    }
+    return best;
+}
+
+void SyncDistance::distances(const glm::vec3* first, const glm::vec3* second,
+                             float* out, size_t n)
+{
+    size_t i = 0;
+#ifdef SIMDPACK_SSE
+    // Four points are twelve floats: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+    const float* a = reinterpret_cast<const float*>(first);
+    const float* b = reinterpret_cast<const float*>(second);
+    for ( ; i + 4 <= n; i += 4 ) {
+        const float* pa = a + 3 * i;
+        const float* pb = b + 3 * i;
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(pa),     _mm_loadu_ps(pb));
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(pa + 4), _mm_loadu_ps(pb + 4));
+        __m128 d2 = _mm_sub_ps(_mm_loadu_ps(pa + 8), _mm_loadu_ps(pb + 8));
+
+        // Transpose to x0 x1 x2 x3, y0 y1 y2 y3 and z0 z1 z2 z3
+        __m128 x = _mm_shuffle_ps(d0, _mm_shuffle_ps(d1, d2, _MM_SHUFFLE(1, 0, 2, 0)),
+                                  _MM_SHUFFLE(3, 1, 3, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(d0, d1, _MM_SHUFFLE(0, 0, 1, 1)),
+                                  _mm_shuffle_ps(d1, d2, _MM_SHUFFLE(2, 2, 3, 3)),
+                                  _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(d0, d1, _MM_SHUFFLE(1, 1, 2, 2)), d2,
+                                  _MM_SHUFFLE(3, 0, 2, 0));
+
+        __m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                    _mm_mul_ps(z, z));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(squared));
+    }
+#endif
+    for ( ; i < n; i++ )
+        out[i] = glm::distance(first[i], second[i]);
+}
@@ -0,0 +1,155 @@
+#include <threadpool.hpp>
+
+ThreadPool::ThreadPool(unsigned int nThreads)
+    : mStop(false)
+{
+    /// hardware_concurrency() may be unknown.
+    if (nThreads == 0)
+    {
+        nThreads = 1;
+    }
+
+    for (unsigned int i = 0; i < nThreads; ++i)
+    {
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+unsigned int ThreadPool::getNThreads() const
+{
+    return mWorkers.size();
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                             const std::function<void(size_t, size_t)>& body)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    if (grain == 0)
+    {
+        grain = 1;
+    }
+
+    const size_t nChunks = (end - begin + grain - 1) / grain;
+    if (nChunks == 1)
+    {
+        body(begin, end);
+        return;
+    }
+
+    /// Chunks are claimed from shared counter by helpers and caller.
+    /// First exception is kept and rethrown on caller once all claimed
+    /// chunks are finished, chunks claimed after it are skipped.
+    struct State
+    {
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::atomic<bool> failed;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+    state->next = 0;
+    state->done = 0;
+    state->failed = false;
+
+    auto work = [state, begin, end, grain, nChunks, &body]()
+    {
+        size_t chunk;
+        while ((chunk = state->next++) < nChunks)
+        {
+            if (!state->failed)
+            {
+                try
+                {
+                    size_t chunkBegin = begin + chunk * grain;
+                    body(chunkBegin, std::min(chunkBegin + grain, end));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error)
+                    {
+                        state->error = std::current_exception();
+                    }
+                    state->failed = true;
+                }
+            }
+
+            if (++state->done == nChunks)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    size_t nHelpers = std::min<size_t>(mWorkers.size(), nChunks - 1);
+    for (size_t i = 0; i < nHelpers; ++i)
+    {
+        enqueue(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state, nChunks]()
+    {
+        return state->done == nChunks;
+    });
+
+    if (state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push(std::move(task));
+    }
+    mCondition.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+            if (mStop && mTasks.empty())
+            {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop();
+        }
+        task();
+    }
+}
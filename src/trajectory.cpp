@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include <trajectory.hpp>
+
+Trajectory::Trajectory()
+    : mPoints(nullptr)
+    , mSize(0)
+{
+}
+
+Trajectory::Trajectory(std::vector<glm::vec3> points)
+{
+    mOwned = std::make_shared<std::vector<glm::vec3>>(std::move(points));
+    mPoints = mOwned->data();
+    mSize = mOwned->size();
+}
+
+Trajectory::Trajectory(std::shared_ptr<const void> storage,
+                       const glm::vec3* points, size_t size)
+    : mStorage(std::move(storage))
+    , mPoints(points)
+    , mSize(size)
+{
+}
+
+const glm::vec3* Trajectory::data() const
+{
+    return mPoints;
+}
+
+size_t Trajectory::size() const
+{
+    return mSize;
+}
+
+bool Trajectory::empty() const
+{
+    return mSize == 0;
+}
+
+const glm::vec3& Trajectory::operator[](size_t idx) const
+{
+    return mPoints[idx];
+}
+
+const glm::vec3* Trajectory::begin() const
+{
+    return mPoints;
+}
+
+const glm::vec3* Trajectory::end() const
+{
+    return mPoints + mSize;
+}
+
+Trajectory Trajectory::slice(size_t idx, size_t count) const
+{
+    Trajectory view(*this);
+    view.mPoints = mPoints + idx;
+    view.mSize = count;
+    return view;
+}
+
+void Trajectory::append(const Trajectory& tail)
+{
+    if (tail.empty())
+    {
+        return;
+    }
+    if (empty())
+    {
+        *this = tail;
+        return;
+    }
+
+    const void* storage = mOwned ? mOwned.get() : mStorage.get();
+    const void* tailStorage = tail.mOwned ? tail.mOwned.get() : tail.mStorage.get();
+    if (storage && storage == tailStorage && tail.mPoints == end())
+    {
+        mSize += tail.mSize;
+        return;
+    }
+
+    /// Owned points are extended in place only if nobody else sees them.
+    /// Slice keeps its offset, points before it stay out of view.
+    bool inPlace = mOwned && mOwned.use_count() == 1 && storage != tailStorage &&
+                   end() == mOwned->data() + mOwned->size();
+    size_t offset = 0;
+    if (inPlace)
+    {
+        offset = mPoints - mOwned->data();
+    }
+    else
+    {
+        auto owned = std::make_shared<std::vector<glm::vec3>>();
+        owned->reserve(std::max(2 * mSize, mSize + tail.mSize));
+        owned->assign(begin(), end());
+        mOwned = std::move(owned);
+        mStorage.reset();
+    }
+
+    mOwned->insert(mOwned->end(), tail.begin(), tail.end());
+    mPoints = mOwned->data() + offset;
+    mSize += tail.mSize;
+}
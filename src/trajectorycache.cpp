@@ -0,0 +1,362 @@
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <mappedfile.hpp>
+#include <threadpool.hpp>
+#include <trajectorycache.hpp>
+#include <trajectoryfile.hpp>
+#include <utils.hpp>
+
+namespace
+{
+
+/// Bytes per hashing task.
+const size_t HASH_CHUNK_SIZE = 1 << 22;
+
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME  = 1099511628211ULL;
+
+inline uint64_t fnv1a(uint64_t hash, const char* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/// Hash of file: FNV-1a over hashes of fixed-size chunks.
+uint64_t hashFile(const std::string& fileName)
+{
+    MappedFile file(fileName);
+
+    const size_t nChunks = (file.size() + HASH_CHUNK_SIZE - 1) / HASH_CHUNK_SIZE;
+    std::vector<uint64_t> hashes(nChunks);
+    ThreadPool::instance().parallelFor(0, nChunks, 1, [&](size_t first, size_t last)
+    {
+        for (size_t c = first; c < last; ++c)
+        {
+            size_t begin = c * HASH_CHUNK_SIZE;
+            size_t size = std::min(HASH_CHUNK_SIZE, file.size() - begin);
+            hashes[c] = fnv1a(FNV_OFFSET, file.data() + begin, size);
+        }
+    });
+
+    return fnv1a(FNV_OFFSET, reinterpret_cast<const char*>(hashes.data()),
+                 hashes.size() * sizeof(uint64_t));
+}
+
+struct SourceIdentity
+{
+    std::string fileName;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+};
+
+SourceIdentity identify(const std::string& fileName, bool withHash)
+{
+    struct stat status;
+    if (stat(fileName.c_str(), &status) != 0)
+    {
+        throw std::runtime_error("Can't open file " + fileName);
+    }
+
+    SourceIdentity identity;
+    identity.fileName = fileName;
+    identity.size = status.st_size;
+    identity.mtime = static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 +
+                     status.st_mtim.tv_nsec;
+    identity.hash = withHash ? hashFile(fileName) : 0;
+
+    return identity;
+}
+
+/// One "size mtime hash name" line per source file.
+std::string serialize(const std::vector<SourceIdentity>& identities)
+{
+    std::ostringstream stream;
+    for (const auto& identity : identities)
+    {
+        stream << identity.size << ' ' << identity.mtime << ' '
+               << std::hex << identity.hash << std::dec << ' '
+               << identity.fileName << '\n';
+    }
+    return stream.str();
+}
+
+std::vector<SourceIdentity> deserialize(const std::string& metadata)
+{
+    std::vector<SourceIdentity> identities;
+    std::istringstream stream(metadata);
+    SourceIdentity identity;
+    while (stream >> identity.size >> identity.mtime
+                  >> std::hex >> identity.hash >> std::dec)
+    {
+        stream.get();
+        std::getline(stream, identity.fileName);
+        identities.push_back(identity);
+    }
+    return identities;
+}
+
+std::string absolutePath(const std::string& fileName)
+{
+    char resolved[PATH_MAX];
+    return realpath(fileName.c_str(), resolved) ? std::string(resolved) : fileName;
+}
+
+std::string directoryOf(const std::string& fileName)
+{
+    auto slash = fileName.rfind('/');
+    return slash == std::string::npos ? std::string() : fileName.substr(0, slash + 1);
+}
+
+std::string stemOf(const std::string& fileName)
+{
+    auto slash = fileName.rfind('/');
+    std::string name = slash == std::string::npos ? fileName : fileName.substr(slash + 1);
+    return name.substr(0, name.rfind('.'));
+}
+
+}
+
+TrajectoryCache::TrajectoryCache()
+    : mEnabled(true)
+    , mVerifyContent(false)
+{
+}
+
+bool TrajectoryCache::isEnabled() const
+{
+    return mEnabled;
+}
+
+void TrajectoryCache::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+}
+
+std::string TrajectoryCache::getDirectory() const
+{
+    return mDirectory;
+}
+
+void TrajectoryCache::setDirectory(std::string directory)
+{
+    if (!directory.empty() && directory.back() != '/')
+    {
+        directory += '/';
+    }
+    mDirectory = std::move(directory);
+}
+
+bool TrajectoryCache::getVerifyContent() const
+{
+    return mVerifyContent;
+}
+
+void TrajectoryCache::setVerifyContent(bool verify)
+{
+    mVerifyContent = verify;
+}
+
+Trajectory TrajectoryCache::readPoints(const std::string& xFile,
+                                       const std::string& yFile,
+                                       const std::string& zFile) const
+{
+    const std::vector<std::string> sources = { xFile, yFile, zFile };
+
+    std::string cacheFile = findValid(sources);
+    if (!cacheFile.empty())
+    {
+        return TrajectoryFile::read(cacheFile);
+    }
+
+    std::string metadata = identifySources(sources);
+    auto points = Utils::readPoints(xFile, yFile, zFile);
+    store(sources, metadata, points.data(), points.size());
+
+    return Trajectory(std::move(points));
+}
+
+std::vector<glm::vec2> TrajectoryCache::readPoints(const std::string& xFile,
+                                                   const std::string& yFile) const
+{
+    const std::vector<std::string> sources = { xFile, yFile };
+
+    std::string cacheFile = findValid(sources);
+    if (!cacheFile.empty())
+    {
+        return TrajectoryFile::readPoints2D(cacheFile);
+    }
+
+    std::string metadata = identifySources(sources);
+    auto points = Utils::readPoints(xFile, yFile);
+    store(sources, metadata, points.data(), points.size());
+
+    return points;
+}
+
+void TrajectoryCache::readPoints(const std::string& xFile,
+                                 const std::string& yFile,
+                                 const std::string& zFile,
+                                 const std::function<bool(Trajectory)>& sink) const
+{
+    const std::vector<std::string> sources = { xFile, yFile, zFile };
+
+    std::string cacheFile = findValid(sources);
+    if (!cacheFile.empty())
+    {
+        sink(TrajectoryFile::read(cacheFile));
+        return;
+    }
+
+    /// Blocks are kept for cache, stopped read is not cached.
+    std::string metadata = identifySources(sources);
+    std::vector<glm::vec3> points;
+    bool complete = true;
+    Utils::readPoints(xFile, yFile, zFile,
+                      [&](const glm::vec3* block, size_t count)
+    {
+        if (mEnabled)
+            points.insert(points.end(), block, block + count);
+        complete = sink(Trajectory(std::vector<glm::vec3>(block, block + count)));
+        return complete;
+    });
+
+    if (complete)
+    {
+        store(sources, metadata, points.data(), points.size());
+    }
+}
+
+std::string TrajectoryCache::getCacheFileName(
+        const std::vector<std::string>& sources) const
+{
+    /// Sidecar of x.txt, y.txt, z.txt is .x_y_z.cache.atrj
+    if (mDirectory.empty())
+    {
+        std::string name = directoryOf(sources[0]) + ".";
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            name += (i > 0 ? "_" : "") + stemOf(sources[i]);
+        }
+        return name + SIDECAR_SUFFIX + TrajectoryFile::EXTENSION;
+    }
+
+    /// Shared directory: name is derived from absolute source paths.
+    std::string key;
+    for (const auto& source : sources)
+    {
+        key += absolutePath(source) + '\n';
+    }
+    std::ostringstream name;
+    name << mDirectory << std::hex << fnv1a(FNV_OFFSET, key.data(), key.size())
+         << TrajectoryFile::EXTENSION;
+
+    return name.str();
+}
+
+std::string TrajectoryCache::findValid(const std::vector<std::string>& sources) const
+{
+    if (!mEnabled)
+    {
+        return std::string();
+    }
+
+    std::string cacheFile = getCacheFileName(sources);
+    if (!Utils::fileExists(cacheFile))
+    {
+        return std::string();
+    }
+
+    try
+    {
+        auto cached = deserialize(TrajectoryFile::readMetadata(cacheFile));
+        if (cached.size() != sources.size())
+        {
+            return std::string();
+        }
+
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            auto current = identify(sources[i], mVerifyContent);
+            if (cached[i].fileName != absolutePath(sources[i]) ||
+                cached[i].size != current.size ||
+                cached[i].mtime != current.mtime ||
+                (mVerifyContent && cached[i].hash != current.hash))
+            {
+                return std::string();
+            }
+        }
+    }
+    catch (std::runtime_error&)
+    {
+        /// Broken cache is just rebuilt.
+        return std::string();
+    }
+
+    return cacheFile;
+}
+
+std::string TrajectoryCache::identifySources(
+        const std::vector<std::string>& sources) const
+{
+    if (!mEnabled)
+    {
+        return std::string();
+    }
+
+    try
+    {
+        std::vector<SourceIdentity> identities;
+        for (const auto& source : sources)
+        {
+            identities.push_back(identify(source, true));
+            identities.back().fileName = absolutePath(source);
+        }
+        return serialize(identities);
+    }
+    catch (std::runtime_error&)
+    {
+        /// Missing source is reported by parser.
+        return std::string();
+    }
+}
+
+template <typename Point>
+void TrajectoryCache::store(const std::vector<std::string>& sources,
+                            const std::string& metadata,
+                            const Point* points, size_t count) const
+{
+    if (!mEnabled || metadata.empty())
+    {
+        return;
+    }
+
+    std::string cacheFile = getCacheFileName(sources);
+    try
+    {
+        /// Written under temporary name so readers never see partial file.
+        std::string temporaryFile = cacheFile + "." + std::to_string(getpid());
+        TrajectoryFile::write(temporaryFile, points, count, metadata);
+        if (std::rename(temporaryFile.c_str(), cacheFile.c_str()) != 0)
+        {
+            std::remove(temporaryFile.c_str());
+            throw std::runtime_error("Can't write file " + cacheFile);
+        }
+    }
+    catch (std::runtime_error& exc)
+    {
+        /// Cache is optional, e.g. data directory may be read-only.
+        std::cerr << "Cache is not written: " << exc.what() << std::endl;
+    }
+}
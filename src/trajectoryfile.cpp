@@ -0,0 +1,301 @@
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <mappedfile.hpp>
+#include <threadpool.hpp>
+#include <trajectoryfile.hpp>
+
+namespace
+{
+
+const char MAGIC[4] = { 'A', 'T', 'R', 'J' };
+
+/// Points per task of double to float conversion.
+const size_t CONVERT_GRAIN = 1 << 16;
+
+/// Data offset alignment, enough for any component type.
+const uint64_t DATA_ALIGNMENT = 16;
+
+TrajectoryFile::Header makeHeader(uint64_t count, uint32_t dimension,
+                                  uint32_t precision,
+                                  const std::string& metadata = std::string())
+{
+    TrajectoryFile::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version    = TrajectoryFile::VERSION;
+    header.count      = count;
+    header.dimension  = dimension;
+    header.precision  = precision;
+    header.metadataSize = metadata.size();
+    header.dataOffset = (sizeof(TrajectoryFile::Header) + metadata.size() +
+                         DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+    /// Unused axes keep zero bounds.
+    for (uint32_t axis = 0; axis < dimension && axis < 3; ++axis)
+    {
+        header.boundsMin[axis] = std::numeric_limits<float>::max();
+        header.boundsMax[axis] = std::numeric_limits<float>::lowest();
+    }
+
+    return header;
+}
+
+void includeInBounds(TrajectoryFile::Header& header, int axis, double value)
+{
+    header.boundsMin[axis] = std::min(header.boundsMin[axis], static_cast<float>(value));
+    header.boundsMax[axis] = std::max(header.boundsMax[axis], static_cast<float>(value));
+}
+
+TrajectoryFile::Header validateHeader(const char* data, size_t size,
+                                      const std::string& fileName)
+{
+    TrajectoryFile::Header header;
+    if (size < sizeof(header))
+    {
+        throw std::runtime_error("Trajectory file is too short: " + fileName);
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        throw std::runtime_error("Not a trajectory file: " + fileName);
+    }
+    if (header.version != TrajectoryFile::VERSION)
+    {
+        throw std::runtime_error("Unsupported trajectory file version " +
+                                 std::to_string(header.version) + ": " + fileName);
+    }
+    if (header.precision != sizeof(float) && header.precision != sizeof(double))
+    {
+        throw std::runtime_error("Unsupported trajectory precision " +
+                                 std::to_string(header.precision) + ": " + fileName);
+    }
+    if (header.dimension != 2 && header.dimension != 3)
+    {
+        throw std::runtime_error("Unsupported trajectory dimension " +
+                                 std::to_string(header.dimension) + ": " + fileName);
+    }
+    /// Sizes are checked by division so that forged counts can't overflow.
+    if (header.dataOffset < sizeof(header) ||
+        header.metadataSize > header.dataOffset - sizeof(header) ||
+        header.dataOffset % header.precision != 0 ||
+        header.dataOffset > size ||
+        header.count > (size - header.dataOffset) / (header.dimension * header.precision))
+    {
+        throw std::runtime_error("Trajectory file is truncated: " + fileName);
+    }
+
+    return header;
+}
+
+void writeFile(const std::string& fileName, const TrajectoryFile::Header& header,
+               const std::string& metadata, const char* data, size_t size)
+{
+    std::ofstream output(fileName, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        throw std::runtime_error("Can't open file " + fileName);
+    }
+
+    if (header.dataOffset < sizeof(header) ||
+        metadata.size() > header.dataOffset - sizeof(header))
+    {
+        throw std::runtime_error("Metadata doesn't fit before data of " + fileName);
+    }
+
+    const std::string padding(header.dataOffset - sizeof(header) - metadata.size(), '\0');
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(metadata.data(), metadata.size());
+    output.write(padding.data(), padding.size());
+    output.write(data, size);
+    if (!output)
+    {
+        throw std::runtime_error("Can't write file " + fileName);
+    }
+}
+
+}
+
+TrajectoryFile::Header TrajectoryFile::readHeader(const std::string& fileName)
+{
+    std::ifstream input(fileName, std::ios::binary | std::ios::ate);
+    if (!input.is_open())
+    {
+        throw std::runtime_error("Can't open file " + fileName);
+    }
+    size_t size = input.tellg();
+    input.seekg(0);
+
+    char data[sizeof(Header)];
+    input.read(data, sizeof(data));
+    if (input.gcount() != sizeof(data))
+    {
+        throw std::runtime_error("Trajectory file is too short: " + fileName);
+    }
+
+    return validateHeader(data, size, fileName);
+}
+
+std::string TrajectoryFile::readMetadata(const std::string& fileName)
+{
+    Header header = readHeader(fileName);
+
+    std::ifstream input(fileName, std::ios::binary);
+    input.seekg(sizeof(header));
+
+    std::string metadata(header.metadataSize, '\0');
+    input.read(&metadata[0], metadata.size());
+    if (!input)
+    {
+        throw std::runtime_error("Can't read metadata of " + fileName);
+    }
+
+    return metadata;
+}
+
+Trajectory TrajectoryFile::read(const std::string& fileName)
+{
+    auto file = std::make_shared<const MappedFile>(fileName);
+    Header header = validateHeader(file->data(), file->size(), fileName);
+
+    if (header.dimension != 3)
+    {
+        throw std::runtime_error("Trajectory must be three-dimensional: " + fileName);
+    }
+
+    const char* data = file->data() + header.dataOffset;
+    if (header.precision == sizeof(float))
+    {
+        return Trajectory(file, reinterpret_cast<const glm::vec3*>(data),
+                          header.count);
+    }
+
+    /// Single conversion pass, split over worker pool.
+    std::vector<glm::vec3> points(header.count);
+    const double* values = reinterpret_cast<const double*>(data);
+    ThreadPool::instance().parallelFor(0, points.size(), CONVERT_GRAIN,
+                                       [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            points[i] = glm::vec3(values[3 * i],
+                                  values[3 * i + 1],
+                                  values[3 * i + 2]);
+        }
+    });
+
+    return Trajectory(std::move(points));
+}
+
+std::vector<glm::vec2> TrajectoryFile::readPoints2D(const std::string& fileName)
+{
+    MappedFile file(fileName);
+    Header header = validateHeader(file.data(), file.size(), fileName);
+
+    if (header.dimension != 2)
+    {
+        throw std::runtime_error("Points must be two-dimensional: " + fileName);
+    }
+
+    std::vector<glm::vec2> points(header.count);
+    const char* data = file.data() + header.dataOffset;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            if (header.precision == sizeof(float))
+                points[i][axis] = reinterpret_cast<const float*>(data)[2 * i + axis];
+            else
+                points[i][axis] = reinterpret_cast<const double*>(data)[2 * i + axis];
+        }
+    }
+
+    return points;
+}
+
+void TrajectoryFile::write(const std::string& fileName,
+                           const glm::vec3* points, size_t count,
+                           const std::string& metadata)
+{
+    Header header = makeHeader(count, 3, sizeof(float), metadata);
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            includeInBounds(header, axis, points[i][axis]);
+        }
+    }
+
+    writeFile(fileName, header, metadata, reinterpret_cast<const char*>(points),
+              count * sizeof(glm::vec3));
+}
+
+void TrajectoryFile::write(const std::string& fileName,
+                           const glm::vec2* points, size_t count,
+                           const std::string& metadata)
+{
+    Header header = makeHeader(count, 2, sizeof(float), metadata);
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            includeInBounds(header, axis, points[i][axis]);
+        }
+    }
+
+    writeFile(fileName, header, metadata, reinterpret_cast<const char*>(points),
+              count * sizeof(glm::vec2));
+}
+
+void TrajectoryFile::write(const std::string& fileName,
+                           const std::vector<double>& x,
+                           const std::vector<double>& y,
+                           const std::vector<double>& z,
+                           uint32_t precision)
+{
+    if (precision != sizeof(float) && precision != sizeof(double))
+    {
+        throw std::runtime_error("Unsupported trajectory precision " +
+                                 std::to_string(precision));
+    }
+    if (x.size() != y.size() || (!z.empty() && z.size() != x.size()))
+    {
+        throw std::runtime_error("Axes have different number of points");
+    }
+
+    const uint32_t dimension = z.empty() ? 2 : 3;
+    const std::vector<double>* axes[3] = { &x, &y, &z };
+
+    Header header = makeHeader(x.size(), dimension, precision);
+    std::vector<char> data(x.size() * dimension * precision);
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        for (uint32_t axis = 0; axis < dimension; ++axis)
+        {
+            double value = (*axes[axis])[i];
+            includeInBounds(header, axis, value);
+
+            char* target = &data[(i * dimension + axis) * precision];
+            if (precision == sizeof(float))
+            {
+                float single = static_cast<float>(value);
+                std::memcpy(target, &single, sizeof(single));
+            }
+            else
+            {
+                std::memcpy(target, &value, sizeof(value));
+            }
+        }
+    }
+
+    writeFile(fileName, header, std::string(), data.data(), data.size());
+}
+
+bool TrajectoryFile::hasExtension(const std::string& fileName)
+{
+    const size_t length = sizeof(EXTENSION) - 1;
+    return fileName.size() >= length &&
+           fileName.compare(fileName.size() - length, length, EXTENSION) == 0;
+}
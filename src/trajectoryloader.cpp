@@ -0,0 +1,58 @@
+#include <trajectoryloader.hpp>
+
+TrajectoryLoader::TrajectoryLoader(Source source)
+{
+    mJob.start([this, source]()
+    {
+        source([this](Trajectory part)
+        {
+            if (!part.empty())
+            {
+                mJob.push(std::move(part));
+            }
+            return !mJob.isCancelled();
+        });
+    });
+}
+
+TrajectoryLoader::~TrajectoryLoader()
+{
+    cancel();
+}
+
+bool TrajectoryLoader::poll(Trajectory& points, size_t maxPoints)
+{
+    if (maxPoints == 0 || (mPart.empty() && !mJob.poll(mPart)))
+    {
+        return false;
+    }
+
+    /// Large part is split, the rest is taken by next polls.
+    if (mPart.size() <= maxPoints)
+    {
+        points = std::move(mPart);
+        mPart = Trajectory();
+    }
+    else
+    {
+        points = mPart.slice(0, maxPoints);
+        mPart = mPart.slice(maxPoints, mPart.size() - maxPoints);
+    }
+
+    return true;
+}
+
+bool TrajectoryLoader::isFinished() const
+{
+    return mPart.empty() && mJob.isFinished();
+}
+
+std::string TrajectoryLoader::getError() const
+{
+    return mJob.getError();
+}
+
+void TrajectoryLoader::cancel()
+{
+    mJob.cancel();
+}
@@ -0,0 +1,183 @@
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define TUBEGEOMETRY_SSE
+#include <immintrin.h>
+#endif
+
+#include <tubegeometry.hpp>
+
+namespace
+{
+
+#ifdef TUBEGEOMETRY_SSE
+
+/// Store 4 vertices given by coordinate lanes as 12 interleaved floats.
+inline void storeVertices(float* out, __m128 x, __m128 y, __m128 z)
+{
+    __m128 xy01 = _mm_unpacklo_ps(x, y);
+    __m128 xy23 = _mm_unpackhi_ps(x, y);
+    __m128 zx01 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+    __m128 yz11 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 zx23 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+    __m128 yz33 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+    _mm_storeu_ps(out,     _mm_shuffle_ps(xy01, zx01, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(yz11, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(zx23, yz33, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+inline __m128 madd(__m128 a, __m128 b, __m128 c)
+{
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+#ifdef __AVX__
+inline __m256 madd(__m256 a, __m256 b, __m256 c)
+{
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#endif
+
+/**
+ * Section is kept as radius-scaled SoA arrays, every lane is one section
+ * vertex. Count is either std::integral_constant, which makes compiler
+ * unroll the loop for a fixed section size, or plain int (multiple of 4).
+ */
+template <typename Count>
+void generateRingsSimd(const glm::vec3* positions,
+                       const TubeFrame* frames, size_t nFrames,
+                       const float* sx, const float* sy,
+                       Count count, glm::vec3* rings)
+{
+    const int n = count;
+    float* out = &rings[0].x;
+
+    for (size_t f = 0; f < nFrames; ++f)
+    {
+        const glm::vec3& position = positions[f];
+        const TubeFrame& frame = frames[f];
+        int i = 0;
+
+#ifdef __AVX__
+        const __m256 px8 = _mm256_set1_ps(position.x);
+        const __m256 py8 = _mm256_set1_ps(position.y);
+        const __m256 pz8 = _mm256_set1_ps(position.z);
+        const __m256 ax8 = _mm256_set1_ps(frame.p1.x);
+        const __m256 ay8 = _mm256_set1_ps(frame.p1.y);
+        const __m256 az8 = _mm256_set1_ps(frame.p1.z);
+        const __m256 bx8 = _mm256_set1_ps(frame.p2.x);
+        const __m256 by8 = _mm256_set1_ps(frame.p2.y);
+        const __m256 bz8 = _mm256_set1_ps(frame.p2.z);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256 s = _mm256_loadu_ps(sx + i);
+            __m256 t = _mm256_loadu_ps(sy + i);
+
+            __m256 x = madd(bx8, t, madd(ax8, s, px8));
+            __m256 y = madd(by8, t, madd(ay8, s, py8));
+            __m256 z = madd(bz8, t, madd(az8, s, pz8));
+
+            storeVertices(out + 3 * i, _mm256_castps256_ps128(x),
+                                       _mm256_castps256_ps128(y),
+                                       _mm256_castps256_ps128(z));
+            storeVertices(out + 3 * (i + 4), _mm256_extractf128_ps(x, 1),
+                                             _mm256_extractf128_ps(y, 1),
+                                             _mm256_extractf128_ps(z, 1));
+        }
+#endif
+
+        const __m128 px = _mm_set1_ps(position.x);
+        const __m128 py = _mm_set1_ps(position.y);
+        const __m128 pz = _mm_set1_ps(position.z);
+        const __m128 ax = _mm_set1_ps(frame.p1.x);
+        const __m128 ay = _mm_set1_ps(frame.p1.y);
+        const __m128 az = _mm_set1_ps(frame.p1.z);
+        const __m128 bx = _mm_set1_ps(frame.p2.x);
+        const __m128 by = _mm_set1_ps(frame.p2.y);
+        const __m128 bz = _mm_set1_ps(frame.p2.z);
+
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 s = _mm_loadu_ps(sx + i);
+            __m128 t = _mm_loadu_ps(sy + i);
+
+            storeVertices(out + 3 * i,
+                          madd(bx, t, madd(ax, s, px)),
+                          madd(by, t, madd(ay, s, py)),
+                          madd(bz, t, madd(az, s, pz)));
+        }
+
+        out += 3 * n;
+    }
+}
+
+#endif // TUBEGEOMETRY_SSE
+
+}
+
+void TubeGeometry::generateRings(const glm::vec3* positions,
+                                 const TubeFrame* frames, size_t nFrames,
+                                 const glm::vec2* section, GLsizei nSection,
+                                 GLfloat radius, glm::vec3* rings)
+{
+#ifdef TUBEGEOMETRY_SSE
+    if (nSection > 0 && nSection % 4 == 0)
+    {
+        std::vector<float> sx(nSection);
+        std::vector<float> sy(nSection);
+        for (GLsizei i = 0; i < nSection; ++i)
+        {
+            sx[i] = radius * section[i].x;
+            sy[i] = radius * section[i].y;
+        }
+
+        switch (nSection)
+        {
+        case 4:
+            generateRingsSimd(positions, frames, nFrames, sx.data(), sy.data(),
+                              std::integral_constant<int, 4>(), rings);
+            return;
+        case 16:
+            generateRingsSimd(positions, frames, nFrames, sx.data(), sy.data(),
+                              std::integral_constant<int, 16>(), rings);
+            return;
+        default:
+            generateRingsSimd(positions, frames, nFrames, sx.data(), sy.data(),
+                              static_cast<int>(nSection), rings);
+            return;
+        }
+    }
+#endif
+
+    generateRingsScalar(positions, frames, nFrames, section, nSection, radius, rings);
+}
+
+void TubeGeometry::generateRingsScalar(const glm::vec3* positions,
+                                       const TubeFrame* frames, size_t nFrames,
+                                       const glm::vec2* section, GLsizei nSection,
+                                       GLfloat radius, glm::vec3* rings)
+{
+    for (size_t f = 0; f < nFrames; ++f)
+    {
+        const TubeFrame& frame = frames[f];
+        glm::vec3* ring = rings + f * nSection;
+
+        for (GLsizei i = 0; i < nSection; ++i)
+        {
+            ring[i] = positions[f] +
+                radius * section[i].x * frame.p1 +
+                radius * section[i].y * frame.p2;
+        }
+    }
+}
@@ -1,21 +1,561 @@
+#include <sys/stat.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include <mappedfile.hpp>
+#include <threadpool.hpp>
 #include <utils.hpp>
 
-std::vector<double> Utils::readPoints(std::string fileName)
+namespace
+{
+
+/// Bytes per parsing task, boundaries are moved to line ends.
+const size_t CHUNK_SIZE = 1 << 20;
+
+/// Chunks of each file parsed at once by streaming reader.
+const size_t STREAM_BLOCK_CHUNKS = 4;
+
+/// Malformed lines listed in error message.
+const size_t MAX_REPORTED_ERRORS = 5;
+
+struct Chunk
+{
+    const char* begin;
+    const char* end;
+    /// Filled by counting pass.
+    size_t nLines;
+    size_t nValues;
+    /// Filled by prefix sums.
+    size_t firstLine;
+    size_t firstValue;
+    /// Filled by parsing pass, local line numbers.
+    std::vector<size_t> malformedLines;
+};
+
+struct TextFile
+{
+    std::unique_ptr<MappedFile> file;
+    std::vector<Chunk> chunks;
+    size_t nValues;
+};
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c)
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+/// Decimal number with optional sign, fraction and exponent.
+const char* parseNumber(const char* p, const char* end, double& value)
+{
+    static const double POWERS[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const uint64_t MAX_MANTISSA = 100000000000000000ULL;
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+
+    for (; p != end && isDigit(*p); ++p)
+    {
+        anyDigit = true;
+        if (mantissa < MAX_MANTISSA)
+            mantissa = mantissa * 10 + (*p - '0');
+        else
+            ++exponent;
+    }
+    if (p != end && *p == '.')
+    {
+        for (++p; p != end && isDigit(*p); ++p)
+        {
+            anyDigit = true;
+            if (mantissa < MAX_MANTISSA)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                --exponent;
+            }
+        }
+    }
+    if (!anyDigit)
+    {
+        return nullptr;
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q != end && (*q == '-' || *q == '+'))
+        {
+            negativeExponent = *q == '-';
+            ++q;
+        }
+        if (q == end || !isDigit(*q))
+        {
+            return nullptr;
+        }
+
+        int explicitExponent = 0;
+        for (; q != end && isDigit(*q); ++q)
+        {
+            if (explicitExponent < 10000)
+                explicitExponent = explicitExponent * 10 + (*q - '0');
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        p = q;
+    }
+
+    value = static_cast<double>(mantissa);
+    if (exponent < 0)
+        value = -exponent <= 22 ? value / POWERS[-exponent] : value * std::pow(10.0, exponent);
+    else if (exponent > 0)
+        value = exponent <= 22 ? value * POWERS[exponent] : value * std::pow(10.0, exponent);
+    if (negative)
+        value = -value;
+
+    return p;
+}
+
+/// Parses single line, returns false for malformed one.
+inline bool parseLine(const char* p, const char* end, double& value, bool& blank)
+{
+    while (p != end && isBlank(*p))
+        ++p;
+    blank = p == end;
+    if (blank)
+    {
+        return true;
+    }
+
+    const char* next = parseNumber(p, end, value);
+    if (!next)
+    {
+        /// Rare forms (inf, nan) go through strtod. Hex floats stop at x
+        /// and are malformed, as they were with operator>>.
+        std::string token(p, end);
+        char* tokenEnd = nullptr;
+        value = std::strtod(token.c_str(), &tokenEnd);
+        next = p + (tokenEnd - token.c_str());
+        if (next == p)
+        {
+            return false;
+        }
+    }
+
+    while (next != end && isBlank(*next))
+        ++next;
+    return next == end;
+}
+
+TextFile openTextFile(const std::string& fileName)
+{
+    TextFile text;
+    text.file = std::make_unique<MappedFile>(fileName);
+    text.nValues = 0;
+
+    const char* data = text.file->data();
+    const char* end = data + text.file->size();
+    for (const char* begin = data; begin < end; )
+    {
+        const char* chunkEnd = begin + std::min<size_t>(CHUNK_SIZE, end - begin);
+        if (chunkEnd != end)
+        {
+            const char* newLine = static_cast<const char*>(
+                    std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newLine ? newLine + 1 : end;
+        }
+
+        Chunk chunk{};
+        chunk.begin = begin;
+        chunk.end = chunkEnd;
+        text.chunks.push_back(std::move(chunk));
+        begin = chunkEnd;
+    }
+
+    return text;
+}
+
+/// Counting pass: lines and non-blank lines of chunk.
+void countValues(Chunk& chunk)
+{
+    chunk.nLines = 0;
+    chunk.nValues = 0;
+
+    bool blank = true;
+    for (const char* p = chunk.begin; p != chunk.end; ++p)
+    {
+        if (*p == '\n')
+        {
+            ++chunk.nLines;
+            chunk.nValues += !blank;
+            blank = true;
+        }
+        else if (!isBlank(*p))
+        {
+            blank = false;
+        }
+    }
+    /// Last line without line break.
+    if (chunk.begin != chunk.end && chunk.end[-1] != '\n')
+    {
+        ++chunk.nLines;
+        chunk.nValues += !blank;
+    }
+}
+
+void accumulateCounts(TextFile& text)
+{
+    size_t line = 0;
+    size_t value = 0;
+    for (Chunk& chunk : text.chunks)
+    {
+        chunk.firstLine = line;
+        chunk.firstValue = value;
+        line += chunk.nLines;
+        value += chunk.nValues;
+    }
+    text.nValues = value;
+}
+
+/// Parsing pass: value i of file goes to out[i * stride].
+template <typename T>
+void parseChunk(Chunk& chunk, T* out, size_t stride)
+{
+    out += chunk.firstValue * stride;
+
+    size_t line = 0;
+    for (const char* p = chunk.begin; p < chunk.end; ++line)
+    {
+        const char* lineEnd = static_cast<const char*>(
+                std::memchr(p, '\n', chunk.end - p));
+        if (!lineEnd)
+            lineEnd = chunk.end;
+
+        double value;
+        bool blank;
+        if (!parseLine(p, lineEnd, value, blank))
+        {
+            chunk.malformedLines.push_back(line);
+            value = 0.0;
+            blank = false;
+        }
+        if (!blank)
+        {
+            *out = static_cast<T>(value);
+            out += stride;
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+void checkMalformed(const TextFile& text)
 {
-    std::ifstream input;
-    input.open(fileName);
-    if (!input.is_open())
+    std::string message;
+    size_t nErrors = 0;
+    for (const Chunk& chunk : text.chunks)
+    {
+        for (size_t line : chunk.malformedLines)
+        {
+            if (nErrors++ < MAX_REPORTED_ERRORS)
+            {
+                message += "\n" + text.file->fileName() + ":" +
+                           std::to_string(chunk.firstLine + line + 1) +
+                           ": malformed value";
+            }
+        }
+    }
+
+    if (nErrors > 0)
     {
-        throw std::runtime_error("Can't open file " + fileName);
+        if (nErrors > MAX_REPORTED_ERRORS)
+        {
+            message += "\n... " + std::to_string(nErrors - MAX_REPORTED_ERRORS) +
+                       " more";
+        }
+        throw std::runtime_error(std::to_string(nErrors) +
+                                 " malformed line(s):" + message);
     }
+}
 
-    double value = 0.0;
-    std::vector<double> result;
-    /// TODO: Check for reading error.
-    while (input >> value)
+/**
+ * Read axis files concurrently, value i of file f becomes component f
+ * of point i. All files must have same number of values.
+ */
+template <typename T, typename Point>
+std::vector<Point> readAxes(const std::vector<std::string>& fileNames)
+{
+    std::vector<TextFile> texts;
+    for (const auto& fileName : fileNames)
     {
-        result.push_back(value);
+        texts.push_back(openTextFile(fileName));
     }
 
-    return result;
+    /// One flat task list over chunks of all files.
+    std::vector<std::pair<size_t, size_t>> tasks;
+    for (size_t f = 0; f < texts.size(); ++f)
+    {
+        for (size_t c = 0; c < texts[f].chunks.size(); ++c)
+        {
+            tasks.emplace_back(f, c);
+        }
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    pool.parallelFor(0, tasks.size(), 1, [&](size_t first, size_t last)
+    {
+        for (size_t t = first; t < last; ++t)
+        {
+            countValues(texts[tasks[t].first].chunks[tasks[t].second]);
+        }
+    });
+    for (auto& text : texts)
+    {
+        accumulateCounts(text);
+    }
+
+    for (size_t f = 1; f < texts.size(); ++f)
+    {
+        if (texts[f].nValues != texts[0].nValues)
+        {
+            throw std::runtime_error(
+                    "Files have different number of points: " +
+                    fileNames[0] + " has " + std::to_string(texts[0].nValues) +
+                    ", " + fileNames[f] + " has " + std::to_string(texts[f].nValues));
+        }
+    }
+
+    const size_t dimension = sizeof(Point) / sizeof(T);
+    std::vector<Point> points(texts.empty() ? 0 : texts[0].nValues);
+    T* out = reinterpret_cast<T*>(points.data());
+
+    pool.parallelFor(0, tasks.size(), 1, [&](size_t first, size_t last)
+    {
+        for (size_t t = first; t < last; ++t)
+        {
+            size_t f = tasks[t].first;
+            parseChunk(texts[f].chunks[tasks[t].second], out + f, dimension);
+        }
+    });
+
+    for (const auto& text : texts)
+    {
+        checkMalformed(text);
+    }
+
+    return points;
+}
+
+/**
+ * Streaming variant of readAxes: files are parsed in blocks of chunks,
+ * points read from all files so far are passed to sink in order.
+ */
+template <typename T, typename Point>
+void streamAxes(const std::vector<std::string>& fileNames,
+                const std::function<bool(const Point*, size_t)>& sink)
+{
+    std::vector<TextFile> texts;
+    for (const auto& fileName : fileNames)
+    {
+        texts.push_back(openTextFile(fileName));
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    const size_t blockChunks = std::max<size_t>(STREAM_BLOCK_CHUNKS,
+                                                pool.getNThreads());
+    const size_t dimension = sizeof(Point) / sizeof(T);
+
+    /// Values parsed but not yet passed, first line of next chunk.
+    std::vector<std::vector<T>> columns(texts.size());
+    std::vector<size_t> nextChunks(texts.size(), 0);
+    std::vector<size_t> nLines(texts.size(), 0);
+    std::vector<size_t> nValues(texts.size(), 0);
+    std::vector<Point> points;
+
+    while (true)
+    {
+        std::vector<std::pair<size_t, size_t>> tasks;
+        for (size_t f = 0; f < texts.size(); ++f)
+        {
+            size_t end = std::min(nextChunks[f] + blockChunks, texts[f].chunks.size());
+            for (size_t c = nextChunks[f]; c < end; ++c)
+            {
+                tasks.emplace_back(f, c);
+            }
+        }
+        if (tasks.empty())
+        {
+            break;
+        }
+
+        pool.parallelFor(0, tasks.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t t = first; t < last; ++t)
+            {
+                countValues(texts[tasks[t].first].chunks[tasks[t].second]);
+            }
+        });
+
+        /// Chunk values are placed after values left from previous blocks.
+        for (const auto& task : tasks)
+        {
+            Chunk& chunk = texts[task.first].chunks[task.second];
+            chunk.firstLine = nLines[task.first];
+            chunk.firstValue = columns[task.first].size();
+            nLines[task.first] += chunk.nLines;
+            nValues[task.first] += chunk.nValues;
+            columns[task.first].resize(chunk.firstValue + chunk.nValues);
+            nextChunks[task.first] = task.second + 1;
+        }
+
+        pool.parallelFor(0, tasks.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t t = first; t < last; ++t)
+            {
+                size_t f = tasks[t].first;
+                parseChunk(texts[f].chunks[tasks[t].second], columns[f].data(), 1);
+            }
+        });
+
+        for (const auto& text : texts)
+        {
+            checkMalformed(text);
+        }
+
+        size_t nReady = columns[0].size();
+        for (const auto& column : columns)
+        {
+            nReady = std::min(nReady, column.size());
+        }
+        if (nReady == 0)
+        {
+            continue;
+        }
+
+        points.resize(nReady);
+        T* out = reinterpret_cast<T*>(points.data());
+        for (size_t f = 0; f < columns.size(); ++f)
+        {
+            for (size_t i = 0; i < nReady; ++i)
+            {
+                out[i * dimension + f] = columns[f][i];
+            }
+            columns[f].erase(columns[f].begin(), columns[f].begin() + nReady);
+        }
+
+        if (!sink(points.data(), nReady))
+        {
+            return;
+        }
+    }
+
+    for (size_t f = 1; f < texts.size(); ++f)
+    {
+        if (nValues[f] != nValues[0])
+        {
+            throw std::runtime_error(
+                    "Files have different number of points: " +
+                    fileNames[0] + " has " + std::to_string(nValues[0]) +
+                    ", " + fileNames[f] + " has " + std::to_string(nValues[f]));
+        }
+    }
+}
+
+}
+
+std::vector<double> Utils::readPoints(std::string fileName)
+{
+    return readAxes<double, double>({ fileName });
+}
+
+std::vector<glm::vec2> Utils::readPoints(const std::string& xFile,
+                                         const std::string& yFile)
+{
+    return readAxes<float, glm::vec2>({ xFile, yFile });
+}
+
+std::vector<glm::vec3> Utils::readPoints(const std::string& xFile,
+                                         const std::string& yFile,
+                                         const std::string& zFile)
+{
+    return readAxes<float, glm::vec3>({ xFile, yFile, zFile });
+}
+
+void Utils::readPoints(const std::string& xFile,
+                       const std::string& yFile,
+                       const std::string& zFile,
+                       const std::function<bool(const glm::vec3*, size_t)>& sink)
+{
+    streamAxes<float, glm::vec3>({ xFile, yFile, zFile }, sink);
+}
+
+int Utils::parseValues(const char* begin, const char* end,
+                       double* values, int maxValues)
+{
+    auto isSeparator = [](char c) { return isBlank(c) || c == ','; };
+
+    int nValues = 0;
+    for (const char* p = begin; ; )
+    {
+        while (p != end && isSeparator(*p))
+            ++p;
+        if (p == end)
+        {
+            return nValues;
+        }
+        if (nValues == maxValues)
+        {
+            return -1;
+        }
+
+        const char* next = parseNumber(p, end, values[nValues]);
+        if (!next)
+        {
+            /// Rare forms (inf, nan) go through strtod. Hex floats stop at x
+            /// and are malformed, as they were with operator>>.
+            const char* tokenEnd = p;
+            while (tokenEnd != end && !isSeparator(*tokenEnd))
+                ++tokenEnd;
+            std::string token(p, tokenEnd);
+            char* parsedEnd = nullptr;
+            values[nValues] = std::strtod(token.c_str(), &parsedEnd);
+            next = p + (parsedEnd - token.c_str());
+        }
+        if (next == p || (next != end && !isSeparator(*next)))
+        {
+            return -1;
+        }
+
+        ++nValues;
+        p = next;
+    }
+}
+
+bool Utils::fileExists(const std::string& fileName)
+{
+    struct stat status;
+    return stat(fileName.c_str(), &status) == 0 && S_ISREG(status.st_mode);
+}
+
+bool Utils::isPipe(const std::string& fileName)
+{
+    struct stat status;
+    return stat(fileName.c_str(), &status) == 0 && S_ISFIFO(status.st_mode);
 }
@@ -0,0 +1,73 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <ensemble.hpp>
+#include <simdpack.hpp>
+#include <threadpool.hpp>
+
+/// Compares vectorized ensemble stepping against scalar RK4, prints steps/second.
+
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t nTrajectories = argc > 1 ? std::stoul(argv[1]) : 4096;
+    const size_t nPoints = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+    std::cout << WideDoublePack::SIZE << " lanes, "
+              << ThreadPool::instance().getNThreads() << " threads" << std::endl;
+
+    for (const auto& system : OdeSystem::builtIn())
+    {
+        OdeIntegrator::Settings integration;
+        integration.system = system;
+
+        Ensemble::Settings settings;
+        settings.nTrajectories = nTrajectories;
+        settings.nPoints = nPoints;
+        std::vector<glm::dvec3> initial = Ensemble::initialPoints(
+                system.initial, settings.radius, nTrajectories, settings.seed);
+
+        /// Scalar reference: one trajectory at a time.
+        std::vector<glm::vec3> expected(nTrajectories * nPoints);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nTrajectories; ++i)
+        {
+            glm::dvec3 x = initial[i];
+            for (size_t k = 0; k < nPoints; ++k)
+            {
+                if (k > 0)
+                    x = OdeIntegrator::rk4Step(system, x, system.dt);
+                expected[i * nPoints + k] = glm::vec3(x.x * system.scale,
+                                                      x.y * system.scale,
+                                                      x.z * system.scale);
+            }
+        }
+        double scalar = nTrajectories * (nPoints - 1) / seconds(start);
+
+        std::atomic<bool> cancelled(false);
+        start = std::chrono::steady_clock::now();
+        std::vector<glm::vec3> points = Ensemble::integrate(integration, settings,
+                                                            cancelled);
+        double ensemble = nTrajectories * (nPoints - 1) / seconds(start);
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < points.size(); ++i)
+            maxError = std::max(maxError, glm::length(points[i] - expected[i]));
+
+        std::cout << system.name << ": "
+                  << scalar / 1e6 << " Msteps/s scalar, "
+                  << ensemble / 1e6 << " Msteps/s ensemble, "
+                  << "x" << ensemble / scalar << ", "
+                  << "max error " << maxError << std::endl;
+    }
+
+    return 0;
+}
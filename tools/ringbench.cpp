@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <tubegeometry.hpp>
+
+/// Compares SIMD ring kernel against scalar path, prints vertices/second.
+
+typedef void (*RingGenerator)(const glm::vec3*, const TubeFrame*, size_t,
+                              const glm::vec2*, GLsizei, GLfloat, glm::vec3*);
+
+static double measure(RingGenerator generate,
+                      const std::vector<glm::vec3>& positions,
+                      const std::vector<TubeFrame>& frames,
+                      const std::vector<glm::vec2>& section,
+                      std::vector<glm::vec3>& rings, int repeats)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+    {
+        generate(positions.data(), frames.data(), frames.size(), section.data(),
+                 section.size(), 0.01f, rings.data());
+    }
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+    return static_cast<double>(rings.size()) * repeats / elapsed.count();
+}
+
+int main(int argc, const char** argv)
+{
+    const size_t nFrames = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const int repeats = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    std::vector<glm::vec3> positions(nFrames);
+    std::vector<TubeFrame> frames(nFrames);
+    for (size_t i = 0; i < nFrames; ++i)
+    {
+        auto& frame = frames[i];
+        positions[i] = glm::vec3(uniform(random), uniform(random), uniform(random));
+        frame.p1 = glm::vec3(uniform(random), uniform(random), uniform(random));
+        frame.p2 = glm::vec3(uniform(random), uniform(random), uniform(random));
+    }
+
+    for (GLsizei nSection : { 4, 16, 12, 7 })
+    {
+        std::vector<glm::vec2> section;
+        for (GLsizei i = 0; i < nSection; ++i)
+        {
+            float angle = 2.0f * 3.14159265f * i / nSection;
+            section.emplace_back(std::cos(angle), std::sin(angle));
+        }
+
+        std::vector<glm::vec3> expected(nFrames * nSection);
+        std::vector<glm::vec3> rings(nFrames * nSection);
+
+        double scalar = measure(TubeGeometry::generateRingsScalar,
+                                positions, frames, section, expected, repeats);
+        double simd = measure(TubeGeometry::generateRings,
+                              positions, frames, section, rings, repeats);
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < rings.size(); ++i)
+        {
+            maxError = std::max(maxError, glm::length(rings[i] - expected[i]));
+        }
+
+        std::cout << "section " << nSection << ": "
+                  << scalar / 1e6 << " Mvert/s scalar, "
+                  << simd / 1e6 << " Mvert/s kernel, "
+                  << "x" << simd / scalar << ", "
+                  << "max error " << maxError << std::endl;
+    }
+
+    return 0;
+}
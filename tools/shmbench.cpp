@@ -0,0 +1,128 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <pipereader.hpp>
+#include <shmring.hpp>
+
+/// Throughput of shared-memory ring against text pipe, producer is child
+/// process and consumer polls like render loop does.
+
+namespace
+{
+
+const size_t N_POINTS = 20000000;
+const size_t BATCH = 4096;
+const size_t POLL_POINTS = 1 << 18;
+
+std::vector<glm::vec3> makeBatch(size_t first)
+{
+    std::vector<glm::vec3> points(BATCH);
+    for (size_t i = 0; i < BATCH; ++i)
+    {
+        float t = static_cast<float>(first + i) * 1e-3f;
+        points[i] = glm::vec3(std::sin(t), std::cos(t), t * 1e-3f);
+    }
+    return points;
+}
+
+/// Drain stream, returns points per second.
+double consume(TrajectoryStream& stream, size_t& nPoints)
+{
+    auto start = std::chrono::steady_clock::now();
+    nPoints = 0;
+
+    Trajectory points;
+    while (!stream.isFinished())
+    {
+        if (stream.poll(points, POLL_POINTS))
+            nPoints += points.size();
+        if (!stream.getError().empty())
+        {
+            std::cerr << stream.getError() << std::endl;
+            std::exit(1);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return nPoints / elapsed.count();
+}
+
+double benchmarkShm()
+{
+    const std::string name = "/attractor_shmbench_" + std::to_string(getpid());
+
+    ShmRingReader reader(name);
+    pid_t child = fork();
+    if (child == 0)
+    {
+        ShmRingProducer ring(name, 1 << 20);
+        auto points = makeBatch(0);
+        for (size_t i = 0; i < N_POINTS; i += BATCH)
+            ring.write(points.data(), points.size());
+        ring.close();
+
+        /// Keep segment until reader has drained it.
+        while (!ring.isDrained())
+            usleep(1000);
+        std::_Exit(0);
+    }
+
+    size_t nPoints;
+    double rate = consume(reader, nPoints);
+    waitpid(child, nullptr, 0);
+    return rate;
+}
+
+double benchmarkPipe()
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        std::perror("pipe");
+        std::exit(1);
+    }
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(fds[0]);
+        FILE* out = fdopen(fds[1], "w");
+        auto points = makeBatch(0);
+        for (size_t i = 0; i < N_POINTS; i += BATCH)
+            for (const auto& p : points)
+                std::fprintf(out, "%.7g %.7g %.7g\n", p.x, p.y, p.z);
+        std::fclose(out);
+        std::_Exit(0);
+    }
+    close(fds[1]);
+
+    /// Reader takes pipe by name.
+    PipeReader reader("/dev/fd/" + std::to_string(fds[0]));
+    close(fds[0]);
+
+    size_t nPoints;
+    double rate = consume(reader, nPoints);
+    waitpid(child, nullptr, 0);
+    return rate;
+}
+
+}
+
+int main()
+{
+    std::cout << N_POINTS << " points, batches of " << BATCH << std::endl;
+    std::cout << "shared memory ring: " << benchmarkShm() / 1e6 << " Mpoints/s"
+              << std::endl;
+    std::cout << "text pipe:          " << benchmarkPipe() / 1e6 << " Mpoints/s"
+              << std::endl;
+
+    return 0;
+}
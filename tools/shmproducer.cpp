@@ -0,0 +1,77 @@
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <shmring.hpp>
+
+/// Reference producer: integrates Lorenz system into shared-memory ring.
+/// Run as ShmProducer lorenz and view as AttractorViewer shm:lorenz ...
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " <segment> [points] [batch]" << std::endl;
+}
+
+int main(int argc, const char** argv)
+{
+    if (argc < 2 || argc > 4)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const size_t nPoints = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    const size_t batch = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4096;
+    if (batch == 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const double sigma = 10.0, rho = 28.0, beta = 8.0 / 3.0;
+    const double dt = 0.001;
+    auto lorenz = [&](const glm::dvec3& p)
+    {
+        return glm::dvec3(sigma * (p.y - p.x),
+                          p.x * (rho - p.z) - p.y,
+                          p.x * p.y - beta * p.z);
+    };
+
+    try
+    {
+        ShmRingProducer ring(argv[1], 1 << 20);
+
+        glm::dvec3 p(1.0, 1.0, 1.0);
+        std::vector<glm::vec3> points;
+        for (size_t i = 0; i < nPoints; i += batch)
+        {
+            points.clear();
+            for (size_t j = i; j < std::min(i + batch, nPoints); ++j)
+            {
+                glm::dvec3 k1 = lorenz(p);
+                glm::dvec3 k2 = lorenz(p + 0.5 * dt * k1);
+                glm::dvec3 k3 = lorenz(p + 0.5 * dt * k2);
+                glm::dvec3 k4 = lorenz(p + dt * k3);
+                p += dt / 6.0 * (k1 + 2.0 * k2 + 2.0 * k3 + k4);
+                points.emplace_back(p.x * 0.05, p.y * 0.05, p.z * 0.05);
+            }
+            ring.write(points.data(), points.size());
+        }
+        ring.close();
+
+        /// Segment disappears with producer, so wait for viewer to take all.
+        std::cout << "Written " << nPoints << " points" << std::endl;
+        while (!ring.isDrained())
+            usleep(10000);
+    }
+    catch (std::runtime_error& exc)
+    {
+        std::cerr << exc.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <cstring>
+#include <iostream>
+
+#include <trajectoryfile.hpp>
+#include <utils.hpp>
+
+/// Converts x/y/z text triplet into binary trajectory file.
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [--double] <x.txt> <y.txt> [<z.txt>] <output"
+              << TrajectoryFile::EXTENSION << ">" << std::endl
+              << "       " << program
+              << " [--double] <directory/> <output"
+              << TrajectoryFile::EXTENSION << ">" << std::endl;
+}
+
+int main(int argc, const char** argv)
+{
+    uint32_t precision = sizeof(float);
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--double") == 0)
+            precision = sizeof(double);
+        else
+            args.emplace_back(argv[i]);
+    }
+
+    /// Directory form expands to its x.txt, y.txt and z.txt.
+    if (args.size() == 2)
+    {
+        std::string dir = args[0];
+        if (!dir.empty() && dir.back() != '/')
+            dir += '/';
+        args = { dir + "x.txt", dir + "y.txt", dir + "z.txt", args[1] };
+    }
+    if (args.size() != 3 && args.size() != 4)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto x = Utils::readPoints(args[0]);
+        auto y = Utils::readPoints(args[1]);
+        auto z = args.size() == 4 ? Utils::readPoints(args[2])
+                                  : std::vector<double>();
+
+        TrajectoryFile::write(args.back(), x, y, z, precision);
+
+        auto header = TrajectoryFile::readHeader(args.back());
+        std::cout << args.back() << ": " << header.count << " points, "
+                  << header.dimension << "D, "
+                  << header.precision * 8 << "-bit" << std::endl;
+    }
+    catch (std::runtime_error& exc)
+    {
+        std::cerr << exc.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}